@@ -4,19 +4,46 @@
 
 #include <SDL_opengl.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/Config/CommandBuffer.h"
+#include "src/Config/LayerCache.h"
+#include "src/Config/RemoteDisplay.h"
 #include "src/Config/Renderer.h"
+#include "src/Config/RenderThread.h"
+#include "src/Config/Trace.h"
 #include "microui.h"
 #include "src/Constants.h"
+#include "src/Systems/AllocTracker.h"
+#include "src/Systems/FrameScheduler.h"
+#include "src/Systems/LogFile.h"
+#include "src/Systems/LogSearch.h"
 #include "src/Systems/Logger.h"
+#include "src/Systems/MappedLog.h"
+#include "src/Systems/Metrics.h"
+#include "src/Systems/Profiler.h"
+#include "src/Systems/ShmIngest.h"
+#include "src/Systems/SocketIngest.h"
+#include "src/Systems/Subsystem.h"
+#include "src/Systems/TimeSeries.h"
+#include "src/GUI/FrameArena.h"
 #include "src/GUI/UiState.h"
 #include "src/GUI/Components/Menu.h"
 
 SDL_Window *window = NULL;
 static UIState ui_state;
-
-#ifdef __APPLE__
-    static float scale_factor = 1.0f;
-#endif
+static mu_Style base_style;
+static CommandBuffer frame_buffer;
+static int threaded_render;
+static int instanced_render;
+static int layer_cache;
+static int sdf_text;
+static int print_profile;
+static int alloc_trap;
+
+// Window-to-drawable coordinate scale in 16.16 fixed point, updated on resize/display change
+static int input_scale_x = 1 << 16;
+static int input_scale_y = 1 << 16;
 
 // Input handling constants and mappings
 #define KEY_MAP_MASK 0xff
@@ -39,10 +66,10 @@ static const char key_map[256] = {
 };
 
 static void process_frame(mu_Context *ctx) {
+    const char *region = alloc_tracker_enter("process_frame");
+    frame_arena_reset();
     mu_begin(ctx);
 
-    calculate_responsive_dimensions(&ui_state);
-
     if (ui_state.menu_open && ui_state.menu_animation < 1.0f) {
         ui_state.menu_animation += MENU_ANIMATION_STEP;
         if (ui_state.menu_animation > 1.0f) ui_state.menu_animation = 1.0f;
@@ -58,40 +85,100 @@ static void process_frame(mu_Context *ctx) {
     }
 
     mu_end(ctx);
+    alloc_tracker_leave(region);
 }
 
 static int text_width(mu_Font font, const char *text, int len) {
     if (len == -1) { len = strlen(text); }
-    return r_get_text_width(text, len);
+    return r_get_text_width(font, text, len);
 }
 
 static int text_height(mu_Font font) {
-    return r_get_text_height();
+    return r_get_text_height(font);
 }
 
-static void render_commands(mu_Context *ctx) {
-    mu_Command *cmd = NULL;
-    while (mu_next_command(ctx, &cmd)) {
-        switch (cmd->type) {
-            case MU_COMMAND_TEXT:
-                r_draw_text(cmd->text.str, cmd->text.pos, cmd->text.color);
-                break;
-            case MU_COMMAND_RECT:
-                r_draw_rect(cmd->rect.rect, cmd->rect.color);
-                break;
-            case MU_COMMAND_ICON:
-                r_draw_icon(cmd->icon.id, cmd->icon.rect, cmd->icon.color);
-                break;
-            case MU_COMMAND_CLIP:
-                r_set_clip_rect(cmd->clip.rect);
-                break;
-            default:
-                break;
-        }
+// Flattens the finished frame and either draws it here or hands it to the render thread
+static void submit_frame(mu_Context *ctx, const UIState *state) {
+    CommandBuffer *buf = threaded_render ? render_thread_back_buffer() : &frame_buffer;
+    buf->width = state->window_width;
+    buf->height = state->window_height;
+    buf->scale = r_get_scale();
+    buf->clear = mu_color(state->bg_color[0], state->bg_color[1], state->bg_color[2], 255);
+    command_buffer_capture(buf, ctx);
+    trace_record_frame(buf);
+    remote_display_send(buf);
+    profiler_count(PROFILER_FRAMES_DRAWN, 1);
+
+    if (threaded_render) {
+        render_thread_publish();
+    } else {
+        command_buffer_render(buf);
+        r_present();
+    }
+}
+
+static void apply_style_scale(mu_Context *ctx, const int scale) {
+    mu_Style *style = ctx->style;
+    *style = base_style;
+    style->size.x *= scale;
+    style->size.y *= scale;
+    style->padding *= scale;
+    style->spacing *= scale;
+    style->indent *= scale;
+    style->title_height *= scale;
+    style->scrollbar_size *= scale;
+    style->thumb_size *= scale;
+}
+
+// Reads window and drawable sizes and pushes any change through the UI state, renderer
+// and input transform. Returns 1 if anything changed.
+static int sync_window_metrics(mu_Context *ctx, UIState *state) {
+    int window_w, window_h, width, height;
+    SDL_GetWindowSize(window, &window_w, &window_h);
+    SDL_GL_GetDrawableSize(window, &width, &height);
+    if (window_w <= 0 || window_h <= 0) { return 0; }
+
+    input_scale_x = (width << 16) / window_w;
+    input_scale_y = (height << 16) / window_h;
+
+    int changed = 0;
+    const int scale = mu_clamp((width + window_w / 2) / window_w, 1, MAX_UI_SCALE);
+    if (scale != state->scale) {
+        ui_state_set_scale(state, scale);
+        r_set_scale(state->scale);
+        apply_style_scale(ctx, r_get_scale());
+        changed = 1;
+    }
+
+    if (width != state->window_width || height != state->window_height) {
+        ui_state_update_dimensions(state, width, height);
+        changed = 1;
+    }
+    return changed;
+}
+
+// Converts pointer coordinates from window points to drawable pixels, once per event
+static void scale_input(SDL_Event *e) {
+    switch (e->type) {
+        case SDL_MOUSEMOTION:
+            e->motion.x = (e->motion.x * input_scale_x) >> 16;
+            e->motion.y = (e->motion.y * input_scale_y) >> 16;
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            e->button.x = (e->button.x * input_scale_x) >> 16;
+            e->button.y = (e->button.y * input_scale_y) >> 16;
+            break;
+        default:
+            break;
     }
 }
 
 static void handle_event(SDL_Event *e, mu_Context *ctx, int *running, UIState *state) {
+    trace_record_event(e);
+    frame_scheduler_handle_event(e);
+    scale_input(e);
+
     switch (e->type) {
         case SDL_QUIT:
             *running = 0;
@@ -104,44 +191,24 @@ static void handle_event(SDL_Event *e, mu_Context *ctx, int *running, UIState *s
                 case SDL_WINDOWEVENT_SIZE_CHANGED:
                 case SDL_WINDOWEVENT_MAXIMIZED:
                 case SDL_WINDOWEVENT_RESTORED:
-                case SDL_WINDOWEVENT_EXPOSED: {
-                    int width, height;
-                    #ifdef __APPLE__
-                        SDL_GL_GetDrawableSize(window, &width, &height);
-                        
-                        // Update scale factor on window resize
-                        int window_w, window_h;
-                        SDL_GetWindowSize(window, &window_w, &window_h);
-                        scale_factor = (float)width / window_w;
-                    #else
-                        SDL_GetWindowSize(window, &width, &height);
-                    #endif
-                    
-                    if (width != state->window_width || height != state->window_height) {
-                        ui_state_update_dimensions(state, width, height);
-                        r_update_dimensions(width, height);
-                        r_clear(mu_color(state->bg_color[0], state->bg_color[1], state->bg_color[2], 255));
+                case SDL_WINDOWEVENT_EXPOSED:
+                case SDL_WINDOWEVENT_DISPLAY_CHANGED:
+                    if (sync_window_metrics(ctx, state) && frame_scheduler_visible()) {
                         process_frame(ctx);
-                        render_commands(ctx);
-                        r_present();
+                        submit_frame(ctx, state);
                     }
-                }
+                    break;
                 default:
                     break;
             }
             break;
 
-        case SDL_MOUSEMOTION: {
-            #ifdef __APPLE__
-                mu_input_mousemove(ctx, e->motion.x * scale_factor, e->motion.y * scale_factor);
-            #else
-                mu_input_mousemove(ctx, e->motion.x, e->motion.y);
-            #endif
+        case SDL_MOUSEMOTION:
+            mu_input_mousemove(ctx, e->motion.x, e->motion.y);
             break;
-        }
 
         case SDL_MOUSEWHEEL:
-            mu_input_scroll(ctx, 0, e->wheel.y * -30);
+            mu_input_scroll(ctx, 0, e->wheel.y * -30 * state->scale);
             break;
 
         case SDL_TEXTINPUT:
@@ -150,22 +217,13 @@ static void handle_event(SDL_Event *e, mu_Context *ctx, int *running, UIState *s
 
         case SDL_MOUSEBUTTONDOWN:
         case SDL_MOUSEBUTTONUP: {
-            int b = button_map[e->button.button & KEY_MAP_MASK];
-            #ifdef __APPLE__
-                if (b && e->type == SDL_MOUSEBUTTONDOWN) {
-                    mu_input_mousedown(ctx, e->button.x * scale_factor, e->button.y * scale_factor, b);
-                }
-                if (b && e->type == SDL_MOUSEBUTTONUP) {
-                    mu_input_mouseup(ctx, e->button.x * scale_factor, e->button.y * scale_factor, b);
-                }
-            #else
-                if (b && e->type == SDL_MOUSEBUTTONDOWN) {
-                    mu_input_mousedown(ctx, e->button.x, e->button.y, b);
-                }
-                if (b && e->type == SDL_MOUSEBUTTONUP) {
-                    mu_input_mouseup(ctx, e->button.x, e->button.y, b);
-                }
-            #endif
+            const int b = button_map[e->button.button & KEY_MAP_MASK];
+            if (b && e->type == SDL_MOUSEBUTTONDOWN) {
+                mu_input_mousedown(ctx, e->button.x, e->button.y, b);
+            }
+            if (b && e->type == SDL_MOUSEBUTTONUP) {
+                mu_input_mouseup(ctx, e->button.x, e->button.y, b);
+            }
             break;
         }
 
@@ -182,13 +240,80 @@ static void handle_event(SDL_Event *e, mu_Context *ctx, int *running, UIState *s
     }
 }
 
+// Charts the time between drawn frames
+static void record_frame_time(void) {
+    static Uint64 previous;
+    const Uint64 now = SDL_GetPerformanceCounter();
+    if (previous != 0) {
+        metrics_set("frame.ms", (double) (now - previous) * 1000.0 / (double) SDL_GetPerformanceFrequency());
+    }
+    previous = now;
+}
+
+// Draws warm-up frames with the menu open, then N more that must not allocate at all.
+// Returns the process exit status.
+static int run_alloc_check(mu_Context *ctx, const int frames) {
+    ui_state.menu_open = 1;
+    int allocations = 0;
+    for (int i = 0; i < ALLOC_WARMUP_FRAMES + frames; i++) {
+        if (i == ALLOC_WARMUP_FRAMES) {
+            alloc_tracker_arm(alloc_trap);
+        }
+        SDL_Event e;
+        int running = 1;
+        while (SDL_PollEvent(&e)) {
+            handle_event(&e, ctx, &running, &ui_state);
+        }
+        process_frame(ctx);
+        submit_frame(ctx, &ui_state);
+        record_frame_time();
+
+        shm_ingest_drain();
+        socket_ingest_drain();
+        logger_update();
+        const int count = alloc_tracker_end_frame();
+        if (i >= ALLOC_WARMUP_FRAMES) { allocations += count; }
+    }
+
+    alloc_tracker_report();
+    if (allocations > 0) {
+        fprintf(stderr, "%d allocations over %d steady-state frames\n", allocations, frames);
+        return 1;
+    }
+    printf("No allocations over %d steady-state frames\n", frames);
+    return 0;
+}
+
 static void cleanup(mu_Context *ctx) {
-    free(ctx);
+    render_thread_stop();
+    trace_record_stop();
+    remote_display_close();
+    logger_flush();
+    log_file_stop();
+    log_search_stop();
+    mapped_log_close();
+    shm_ingest_close();
+    socket_ingest_close();
+    if (print_profile) {
+        profiler_report();
+        alloc_tracker_report();
+        log_file_report();
+        log_search_report();
+        logger_report();
+        shm_ingest_report();
+        socket_ingest_report();
+        metrics_report();
+        time_series_report();
+    }
+    tracked_free(ctx);
     SDL_DestroyWindow(window);
     SDL_Quit();
 }
 
 int main(int argc, char **argv) {
+    alloc_tracker_install();
+    profiler_startup_begin();
+
     #ifdef __APPLE__
         // Set up SDL for macOS
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
@@ -206,14 +331,61 @@ int main(int argc, char **argv) {
         SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     #endif
 
-    if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+    if (SDL_Init(SUBSYSTEM_STARTUP_FLAGS) != 0) {
         fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
         return 1;
     }
+    profiler_startup_mark("SDL init");
 
     ui_state_init(&ui_state);
     logger_init();
 
+    const char *atlas_path = NULL;
+    const char *trace_path = NULL;
+    const char *remote_address = NULL;
+    const char *log_path = NULL;
+    const char *view_path = NULL;
+    const char *shm_name = NULL;
+    const char *socket_path = NULL;
+    int alloc_check_frames = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--retained") == 0) {
+            ui_state.retained_ui = 1;
+        } else if (strcmp(argv[i], "--render-thread") == 0) {
+            threaded_render = 1;
+        } else if (strcmp(argv[i], "--instanced") == 0) {
+            instanced_render = 1;
+        } else if (strcmp(argv[i], "--layers") == 0) {
+            layer_cache = 1;
+        } else if (strcmp(argv[i], "--sdf-text") == 0) {
+            instanced_render = 1;
+            sdf_text = 1;
+        } else if (strcmp(argv[i], "--atlas") == 0 && i + 1 < argc) {
+            atlas_path = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--remote") == 0 && i + 1 < argc) {
+            remote_address = argv[++i];
+        } else if (strcmp(argv[i], "--log-file") == 0 && i + 1 < argc) {
+            log_path = argv[++i];
+        } else if (strcmp(argv[i], "--view") == 0 && i + 1 < argc) {
+            view_path = argv[++i];
+        } else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--startup-trace") == 0) {
+            profiler_set_startup_trace(1);
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            print_profile = 1;
+        } else if (strcmp(argv[i], "--alloc-trap") == 0) {
+            alloc_trap = 1;
+        } else if (strcmp(argv[i], "--alloc-check") == 0 && i + 1 < argc) {
+            alloc_check_frames = atoi(argv[++i]);
+        }
+    }
+    menu_init(&ui_state);
+
     window = SDL_CreateWindow(
             TITLE_TEXT,
             SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
@@ -226,23 +398,30 @@ int main(int argc, char **argv) {
         SDL_Quit();
         return 1;
     }
+    profiler_startup_mark("window");
+    frame_scheduler_init(window);
 
-    // Initialize scale factor for Retina displays
-    #ifdef __APPLE__
-        int drawable_w, drawable_h, window_w, window_h;
-        SDL_GL_GetDrawableSize(window, &drawable_w, &drawable_h);
-        SDL_GetWindowSize(window, &window_w, &window_h);
-        scale_factor = (float)drawable_w / window_w;
-    #endif
-
-    if (r_init() != 0) {
+    if (r_init(atlas_path) != 0) {
         fprintf(stderr, "Renderer initialization failed\n");
         SDL_DestroyWindow(window);
         SDL_Quit();
         return 1;
     }
 
-    mu_Context *ctx = malloc(sizeof(mu_Context));
+    if (instanced_render && r_enable_instancing() != 0) {
+        fprintf(stderr, "Falling back to the fixed-function renderer\n");
+    } else if (sdf_text && r_enable_sdf_text() != 0) {
+        fprintf(stderr, "Falling back to bitmap text\n");
+    }
+    if (layer_cache) {
+        layer_cache_set_enabled(1);
+        if (!r_layers_supported()) {
+            fprintf(stderr, "Layer cache unavailable (needs framebuffer objects)\n");
+        }
+    }
+    profiler_startup_mark("renderer setup");
+
+    mu_Context *ctx = tracked_malloc(ALLOC_UI, sizeof(mu_Context));
     if (ctx == NULL) {
         fprintf(stderr, "Failed to allocate memory for mu_Context\n");
         SDL_DestroyWindow(window);
@@ -253,21 +432,87 @@ int main(int argc, char **argv) {
     mu_init(ctx);
     ctx->text_width = text_width;
     ctx->text_height = text_height;
+    base_style = *ctx->style;
+    sync_window_metrics(ctx, &ui_state);
+
+    if (trace_path != NULL && trace_record_start(trace_path) != 0) {
+        fprintf(stderr, "Recording disabled\n");
+    }
+
+    if (log_path != NULL && log_file_start(log_path) != 0) {
+        fprintf(stderr, "Log file disabled\n");
+    }
+
+    if (view_path != NULL) {
+        if (mapped_log_open(view_path) == 0) {
+            ui_state.menu_open = 1;
+        } else {
+            fprintf(stderr, "Log viewer disabled\n");
+        }
+    }
+
+    int ingesting = 0;
+    if (shm_name != NULL) {
+        if (shm_ingest_open(shm_name) == 0) {
+            ingesting = 1;
+        } else {
+            fprintf(stderr, "Shared-memory ingest disabled\n");
+        }
+    }
+
+    if (socket_path != NULL) {
+        if (socket_ingest_open(socket_path) == 0) {
+            ingesting = 1;
+        } else {
+            fprintf(stderr, "Socket ingest disabled\n");
+        }
+    }
+    frame_scheduler_set_background_work(ingesting);
+
+    if (log_search_start() != 0) {
+        fprintf(stderr, "Log search disabled\n");
+    }
+
+    if (remote_address != NULL && remote_display_listen(remote_address) != 0) {
+        fprintf(stderr, "Remote display disabled\n");
+    }
+
+    // The first present closes the trace, possibly on the render thread
+    profiler_startup_mark("UI setup");
+    if (threaded_render && render_thread_start() != 0) {
+        fprintf(stderr, "Falling back to rendering on the main thread\n");
+        threaded_render = 0;
+    }
+
+    if (alloc_check_frames > 0) {
+        const int status = run_alloc_check(ctx, alloc_check_frames);
+        cleanup(ctx);
+        return status;
+    }
 
     int running = 1;
+    int frames_drawn = 0;
     while (running) {
         SDL_Event e;
         while (SDL_PollEvent(&e)) {
             handle_event(&e, ctx, &running, &ui_state);
         }
 
-        process_frame(ctx);
-
-        r_clear(mu_color(ui_state.bg_color[0], ui_state.bg_color[1], ui_state.bg_color[2], 255));
-        render_commands(ctx);
-        r_present();
+        // Nothing is built or presented while the window can't be seen
+        if (frame_scheduler_visible()) {
+            process_frame(ctx);
+            submit_frame(ctx, &ui_state);
+            record_frame_time();
+            if (++frames_drawn == ALLOC_WARMUP_FRAMES) {
+                alloc_tracker_arm(alloc_trap);
+            }
+        }
+        shm_ingest_drain();
+        socket_ingest_drain();
+        logger_update();
+        alloc_tracker_end_frame();
 
-        SDL_Delay(FRAME_DELAY_MS);
+        frame_scheduler_wait();
     }
 
     cleanup(ctx);
@@ -0,0 +1,188 @@
+#include "src/Client/ShmRing.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SHM_NAME_MAX 256
+
+#ifdef _WIN32
+
+ShmRing *shm_ring_create(const char *name) {
+    fprintf(stderr, "Shared-memory ingestion is not supported on this platform\n");
+    return NULL;
+}
+
+ShmRing *shm_ring_attach(const char *name) {
+    return NULL;
+}
+
+void shm_ring_unmap(ShmRing *ring) {}
+
+void shm_ring_destroy(ShmRing *ring, const char *name) {}
+
+int shm_ring_push(ShmRing *ring, ShmMessageType type, int level, double value, const char *text, int length) {
+    return -1;
+}
+
+int shm_ring_pop(ShmRing *ring, ShmMessage *out) {
+    return 0;
+}
+
+#else
+
+// Object names must start with a slash; "sife" and "/sife" name the same ring
+static int object_name(const char *name, char *out) {
+    const int len = snprintf(out, SHM_NAME_MAX, "%s%s", name[0] == '/' ? "" : "/", name);
+    return len > 0 && len < SHM_NAME_MAX ? 0 : -1;
+}
+
+static ShmRing *map_ring(const int fd) {
+    void *map = mmap(NULL, sizeof(ShmRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+ShmRing *shm_ring_create(const char *name) {
+    char path[SHM_NAME_MAX];
+    if (object_name(name, path) != 0) {
+        fprintf(stderr, "Invalid shared-memory name %s\n", name);
+        return NULL;
+    }
+
+    // A ring left behind by a SiFe that crashed is closed first, or its clients would keep
+    // writing into it instead of attaching to the new one
+    ShmRing *stale = shm_ring_attach(name);
+    if (stale != NULL) {
+        atomic_store_explicit(&stale->closed, 1, memory_order_release);
+        shm_ring_unmap(stale);
+    }
+    shm_unlink(path);
+    const int fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create shared memory %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(ShmRing)) != 0) {
+        fprintf(stderr, "Failed to size shared memory %s: %s\n", path, strerror(errno));
+        close(fd);
+        shm_unlink(path);
+        return NULL;
+    }
+    ShmRing *ring = map_ring(fd);
+    if (ring == NULL) {
+        fprintf(stderr, "Failed to map shared memory %s: %s\n", path, strerror(errno));
+        shm_unlink(path);
+        return NULL;
+    }
+
+    // ftruncate zeroed everything else; producers check the magic last
+    for (uint32_t i = 0; i < SHM_RING_SLOTS; i++) {
+        atomic_store_explicit(&ring->slots[i].sequence, i, memory_order_relaxed);
+    }
+    ring->version = SHM_RING_VERSION;
+    ring->slot_count = SHM_RING_SLOTS;
+    ring->slot_size = sizeof(ShmSlot);
+    atomic_thread_fence(memory_order_release);
+    ring->magic = SHM_RING_MAGIC;
+    return ring;
+}
+
+ShmRing *shm_ring_attach(const char *name) {
+    char path[SHM_NAME_MAX];
+    if (object_name(name, path) != 0) { return NULL; }
+
+    const int fd = shm_open(path, O_RDWR, 0);
+    if (fd < 0) { return NULL; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(ShmRing)) {
+        close(fd);
+        return NULL;
+    }
+    ShmRing *ring = map_ring(fd);
+    if (ring == NULL) { return NULL; }
+
+    atomic_thread_fence(memory_order_acquire);
+    if (ring->magic != SHM_RING_MAGIC || ring->version != SHM_RING_VERSION ||
+        ring->slot_count != SHM_RING_SLOTS || ring->slot_size != sizeof(ShmSlot) ||
+        atomic_load_explicit(&ring->closed, memory_order_acquire)) {
+        munmap(ring, sizeof(ShmRing));
+        return NULL;
+    }
+    return ring;
+}
+
+void shm_ring_unmap(ShmRing *ring) {
+    if (ring != NULL) { munmap(ring, sizeof(ShmRing)); }
+}
+
+void shm_ring_destroy(ShmRing *ring, const char *name) {
+    if (ring == NULL) { return; }
+    atomic_store_explicit(&ring->closed, 1, memory_order_release);
+    shm_ring_unmap(ring);
+
+    char path[SHM_NAME_MAX];
+    if (object_name(name, path) == 0) { shm_unlink(path); }
+}
+
+int shm_ring_push(ShmRing *ring, const ShmMessageType type, const int level, const double value,
+                  const char *text, int length) {
+    uint32_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    ShmSlot *slot;
+    for (;;) {
+        slot = &ring->slots[pos & (SHM_RING_SLOTS - 1)];
+        const uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        const int32_t diff = (int32_t) (sequence - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The consumer hasn't handed this slot back yet: the ring is full
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+
+    if (length > SHM_RING_TEXT_MAX) { length = SHM_RING_TEXT_MAX; }
+    if (length < 0) { length = 0; }
+    slot->type = (uint8_t) type;
+    slot->level = (uint8_t) level;
+    slot->length = (uint16_t) length;
+    slot->pid = (int32_t) getpid();
+    slot->value = value;
+    memcpy(slot->text, text, length);
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    return 0;
+}
+
+int shm_ring_pop(ShmRing *ring, ShmMessage *out) {
+    const uint32_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    ShmSlot *slot = &ring->slots[pos & (SHM_RING_SLOTS - 1)];
+    const uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != pos + 1) { return 0; }
+
+    const int length = slot->length <= SHM_RING_TEXT_MAX ? slot->length : SHM_RING_TEXT_MAX;
+    out->type = (ShmMessageType) slot->type;
+    out->level = slot->level;
+    out->length = length;
+    out->pid = slot->pid;
+    out->value = slot->value;
+    memcpy(out->text, slot->text, length);
+    out->text[length] = '\0';
+
+    atomic_store_explicit(&slot->sequence, pos + SHM_RING_SLOTS, memory_order_release);
+    atomic_store_explicit(&ring->tail, pos + 1, memory_order_relaxed);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define SHM_RING_MAGIC 0x53694665u
+#define SHM_RING_VERSION 1
+#define SHM_RING_SLOTS 4096
+#define SHM_RING_TEXT_MAX 231
+
+typedef enum {
+    SHM_MESSAGE_LOG,
+    SHM_MESSAGE_METRIC
+} ShmMessageType;
+
+/*
+ * A bounded multi-producer, single-consumer queue in a POSIX shared-memory object. Each
+ * slot carries a sequence number: slot i starts at i, a producer may fill it when the
+ * sequence equals the head position it claimed, and publishes it by setting the sequence
+ * to position + 1. The consumer takes the slot at tail once it sees position + 1 and hands
+ * it back by adding SHM_RING_SLOTS. Producers claim positions with a CAS on head, so they
+ * never wait on each other or on the consumer; a producer that finds its slot not yet
+ * handed back counts the message in dropped instead of blocking.
+ *
+ * A producer killed between claiming a slot and publishing it stalls the consumer at that
+ * slot until the ring is created again.
+ *
+ * Slots are 256 bytes: a log line or metric name of up to SHM_RING_TEXT_MAX bytes, not
+ * NUL-terminated, plus the metric value.
+ */
+typedef struct {
+    _Atomic uint32_t sequence;
+    uint8_t type;
+    uint8_t level;
+    uint16_t length;
+    int32_t pid;
+    double value;
+    char text[SHM_RING_TEXT_MAX + 1];
+} ShmSlot;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;
+    // Set by the consumer when it goes away, so producers know to attach again
+    _Atomic uint32_t closed;
+    _Alignas(64) _Atomic uint32_t head;
+    _Atomic uint32_t dropped;
+    _Alignas(64) _Atomic uint32_t tail;
+    _Alignas(64) ShmSlot slots[SHM_RING_SLOTS];
+} ShmRing;
+
+// A message as the consumer sees it; text is NUL-terminated
+typedef struct {
+    ShmMessageType type;
+    int level;
+    int length;
+    int pid;
+    double value;
+    char text[SHM_RING_TEXT_MAX + 1];
+} ShmMessage;
+
+// Consumer side: creates the object, replacing one left behind by an earlier run
+ShmRing *shm_ring_create(const char *name);
+
+// Producer side: maps an object the consumer created. Returns NULL if there is none yet.
+ShmRing *shm_ring_attach(const char *name);
+
+void shm_ring_unmap(ShmRing *ring);
+
+// Marks the ring closed, unmaps it and removes the name
+void shm_ring_destroy(ShmRing *ring, const char *name);
+
+// Returns 0, or -1 when the ring is full and the message was dropped. Text longer than
+// SHM_RING_TEXT_MAX is cut.
+int shm_ring_push(ShmRing *ring, ShmMessageType type, int level, double value, const char *text, int length);
+
+// Consumer only: moves the oldest message into out. Returns 1, or 0 when the ring is empty.
+int shm_ring_pop(ShmRing *ring, ShmMessage *out);
+
+#endif
@@ -0,0 +1,113 @@
+#include "src/Client/SifeClient.h"
+#include "src/Client/ShmRing.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ATTACH_RETRY_MS 250
+
+_Static_assert(SIFE_CLIENT_TEXT_MAX == SHM_RING_TEXT_MAX, "client and ring text limits differ");
+
+/*
+ * The ring in use is swapped when SiFe closes it. Another thread may still be pushing into
+ * the old one, so old mappings are only unmapped by sife_client_close; the list of them
+ * grows with every restart the client sees.
+ */
+struct SifeClient {
+    const char *name;
+    _Atomic(ShmRing *) ring;
+    _Atomic unsigned long dropped;
+    _Atomic uint64_t next_attach_ms;
+    atomic_flag attaching;
+    ShmRing **retired;
+    int retired_count;
+    int retired_capacity;
+};
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int retire(SifeClient *client, ShmRing *ring) {
+    if (client->retired_count == client->retired_capacity) {
+        const int capacity = client->retired_capacity > 0 ? 2 * client->retired_capacity : 4;
+        ShmRing **grown = realloc(client->retired, capacity * sizeof(ShmRing *));
+        if (grown == NULL) { return 0; }
+        client->retired = grown;
+        client->retired_capacity = capacity;
+    }
+    client->retired[client->retired_count++] = ring;
+    return 1;
+}
+
+// Attaches to the current ring when there is none or SiFe has closed it, at most every
+// ATTACH_RETRY_MS
+static ShmRing *current_ring(SifeClient *client) {
+    ShmRing *ring = atomic_load_explicit(&client->ring, memory_order_acquire);
+    if (ring != NULL && !atomic_load_explicit(&ring->closed, memory_order_relaxed)) { return ring; }
+
+    const uint64_t now = now_ms();
+    if (now < atomic_load_explicit(&client->next_attach_ms, memory_order_relaxed) ||
+        atomic_flag_test_and_set_explicit(&client->attaching, memory_order_acquire)) {
+        return NULL;
+    }
+    atomic_store_explicit(&client->next_attach_ms, now + ATTACH_RETRY_MS, memory_order_relaxed);
+
+    ShmRing *fresh = shm_ring_attach(client->name);
+    if (fresh != NULL && ring != NULL && !retire(client, ring)) {
+        // Nowhere to keep the old mapping; stay on the closed ring and try again later
+        shm_ring_unmap(fresh);
+        fresh = NULL;
+    }
+    if (fresh != NULL) { atomic_store_explicit(&client->ring, fresh, memory_order_release); }
+    atomic_flag_clear_explicit(&client->attaching, memory_order_release);
+    return fresh;
+}
+
+static int publish(SifeClient *client, const ShmMessageType type, const int level, const double value,
+                   const char *text) {
+    ShmRing *ring = current_ring(client);
+    if (ring == NULL || shm_ring_push(ring, type, level, value, text, (int) strlen(text)) != 0) {
+        atomic_fetch_add_explicit(&client->dropped, 1, memory_order_relaxed);
+        return -1;
+    }
+    return 0;
+}
+
+SifeClient *sife_client_open(const char *name) {
+    SifeClient *client = calloc(1, sizeof(SifeClient));
+    if (client == NULL) { return NULL; }
+    client->name = strdup(name);
+    if (client->name == NULL) {
+        free(client);
+        return NULL;
+    }
+    atomic_flag_clear(&client->attaching);
+    current_ring(client);
+    return client;
+}
+
+int sife_client_log(SifeClient *client, const int level, const char *text) {
+    return publish(client, SHM_MESSAGE_LOG, level, 0.0, text);
+}
+
+int sife_client_metric(SifeClient *client, const char *name, const double value) {
+    return publish(client, SHM_MESSAGE_METRIC, 0, value, name);
+}
+
+unsigned long sife_client_dropped(const SifeClient *client) {
+    return atomic_load_explicit(&client->dropped, memory_order_relaxed);
+}
+
+void sife_client_close(SifeClient *client) {
+    if (client == NULL) { return; }
+    shm_ring_unmap(atomic_load(&client->ring));
+    for (int i = 0; i < client->retired_count; i++) {
+        shm_ring_unmap(client->retired[i]);
+    }
+    free(client->retired);
+    free((char *) client->name);
+    free(client);
+}
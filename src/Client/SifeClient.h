@@ -0,0 +1,37 @@
+#ifndef SIFE_CLIENT_H
+#define SIFE_CLIENT_H
+
+// Publishes log lines and metric samples from another process to a SiFe started with
+// --shm NAME. Nothing here blocks: when SiFe falls behind and its ring fills up, messages
+// are dropped and counted on both sides. A client opened before SiFe starts, or kept
+// across a SiFe restart (even after a crash), attaches to the new ring on its next call.
+// Moving to a new ring is the only time a call allocates; the old mapping is kept until
+// sife_client_close, since another thread may still be writing to it.
+//
+// Link the SifeClient library; it doesn't depend on SDL. Calls may come from any thread.
+typedef struct SifeClient SifeClient;
+
+// Matches SiFe's log levels
+enum {
+    SIFE_LEVEL_DEBUG,
+    SIFE_LEVEL_INFO,
+    SIFE_LEVEL_WARN,
+    SIFE_LEVEL_ERROR
+};
+
+// Longest line or metric name kept; longer ones are cut
+#define SIFE_CLIENT_TEXT_MAX 231
+
+SifeClient *sife_client_open(const char *name);
+
+// Returns 0, or -1 when the line was dropped
+int sife_client_log(SifeClient *client, int level, const char *text);
+
+int sife_client_metric(SifeClient *client, const char *name, double value);
+
+// Messages this client has dropped so far
+unsigned long sife_client_dropped(const SifeClient *client);
+
+void sife_client_close(SifeClient *client);
+
+#endif
@@ -0,0 +1,415 @@
+#include "src/Config/Atlas.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <SDL2/SDL.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The embedded atlas is compiled into this translation unit only. When the atlas is baked
+// at build time the repacked header generated by sife_atlas_bake replaces the source one.
+#ifdef SIFE_BAKED_ATLAS
+#include "atlas_baked.inl"
+#else
+#include "src/Config/atlas.inl"
+#endif
+
+#ifndef ATLAS_LINE_HEIGHT
+#define ATLAS_LINE_HEIGHT 18
+#endif
+
+/*
+ * File layout (all integers little-endian):
+ *   char     magic[4]      "SFAT"
+ *   uint16   version
+ *   uint16   flags         ATLAS_FLAG_*
+ *   uint16   width, height
+ *   uint16   line_height
+ *   uint16   rect_count
+ *   uint32   pixel_bytes   size of the pixel payload as stored
+ *   int16    rects[rect_count][4]
+ *   uint8    pixels[pixel_bytes]  raw alpha, or RLE packets when ATLAS_FLAG_RLE is set
+ *
+ * RLE packets: control byte c < 128 is followed by c + 1 literal bytes; c >= 128 is
+ * followed by one byte repeated c - 126 times. The encoder only repeats runs of three or
+ * more, which always saves a byte, so nothing grows by more than a control byte per
+ * RLE_MAX_LITERAL bytes, plus one.
+ */
+#define ATLAS_HEADER_SIZE 20
+#define RLE_MAX_LITERAL 128
+#define RLE_MIN_REPEAT 2
+#define RLE_MAX_REPEAT 129
+#define RLE_MIN_ENCODED_REPEAT 3
+#define SDF_INFINITY 1e20f
+
+static unsigned read_u16(const unsigned char *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t read_u32(const unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void write_u16(unsigned char *p, const unsigned v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void write_u32(unsigned char *p, const uint32_t v) {
+    write_u16(p, v & 0xffff);
+    write_u16(p + 2, v >> 16);
+}
+
+void atlas_load_embedded(Atlas *out) {
+    memset(out, 0, sizeof(*out));
+    out->width = ATLAS_WIDTH;
+    out->height = ATLAS_HEIGHT;
+    out->line_height = ATLAS_LINE_HEIGHT;
+    out->rect_count = sizeof(atlas) / sizeof(atlas[0]);
+    memcpy(out->rects, atlas, sizeof(atlas));
+    out->pixels = atlas_texture;
+}
+
+static int rle_decode(const unsigned char *src, const size_t src_size, unsigned char *dst, const size_t dst_size) {
+    size_t in = 0, out = 0;
+    while (in < src_size && out < dst_size) {
+        const unsigned c = src[in++];
+        if (c < RLE_MAX_LITERAL) {
+            const size_t n = c + 1;
+            if (in + n > src_size || out + n > dst_size) { return -1; }
+            memcpy(dst + out, src + in, n);
+            in += n;
+            out += n;
+        } else {
+            const size_t n = c - (RLE_MAX_LITERAL - RLE_MIN_REPEAT);
+            if (in >= src_size || out + n > dst_size) { return -1; }
+            memset(dst + out, src[in++], n);
+            out += n;
+        }
+    }
+    return out == dst_size ? 0 : -1;
+}
+
+static size_t rle_encode(const unsigned char *src, const size_t size, unsigned char *dst) {
+    size_t in = 0, out = 0;
+    while (in < size) {
+        size_t run = 1;
+        while (in + run < size && run < RLE_MAX_REPEAT && src[in + run] == src[in]) { run++; }
+
+        if (run >= RLE_MIN_ENCODED_REPEAT) {
+            dst[out++] = (unsigned char) (run + RLE_MAX_LITERAL - RLE_MIN_REPEAT);
+            dst[out++] = src[in];
+            in += run;
+            continue;
+        }
+
+        // Literal packet: extend until a run long enough to repeat starts
+        size_t len = 1;
+        while (in + len < size && len < RLE_MAX_LITERAL &&
+               !(in + len + 2 < size && src[in + len] == src[in + len + 1] &&
+                 src[in + len] == src[in + len + 2])) {
+            len++;
+        }
+        dst[out++] = (unsigned char) (len - 1);
+        memcpy(dst + out, src + in, len);
+        out += len;
+        in += len;
+    }
+    return out;
+}
+
+static void *map_file(const char *path, size_t *size) {
+#ifdef _WIN32
+    return SDL_LoadFile(path, size);
+#else
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) { return NULL; }
+
+    struct stat st;
+    void *data = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            data = NULL;
+        } else {
+            *size = st.st_size;
+        }
+    }
+    close(fd);
+    return data;
+#endif
+}
+
+static void unmap_file(void *data, const size_t size) {
+#ifdef _WIN32
+    (void) size;
+    SDL_free(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+int atlas_load(Atlas *out, const char *path) {
+    memset(out, 0, sizeof(*out));
+
+    size_t size = 0;
+    const unsigned char *data = map_file(path, &size);
+    if (data == NULL) { return -1; }
+
+    if (size < ATLAS_HEADER_SIZE || memcmp(data, ATLAS_FILE_MAGIC, 4) != 0 ||
+        read_u16(data + 4) != ATLAS_FILE_VERSION) {
+        fprintf(stderr, "Invalid atlas file: %s\n", path);
+        unmap_file((void *) data, size);
+        return -1;
+    }
+
+    const unsigned flags = read_u16(data + 6);
+    out->width = read_u16(data + 8);
+    out->height = read_u16(data + 10);
+    out->line_height = read_u16(data + 12);
+    out->rect_count = read_u16(data + 14);
+    const uint32_t pixel_bytes = read_u32(data + 16);
+    const size_t rects_offset = ATLAS_HEADER_SIZE;
+    const size_t pixels_offset = rects_offset + (size_t) out->rect_count * 8;
+    const size_t pixel_count = (size_t) out->width * out->height;
+
+    if (out->rect_count < ATLAS_MIN_RECTS || out->rect_count > ATLAS_MAX_RECTS ||
+        pixels_offset + pixel_bytes > size || pixel_count == 0 ||
+        (!(flags & ATLAS_FLAG_RLE) && pixel_bytes != pixel_count)) {
+        fprintf(stderr, "Corrupt atlas file: %s\n", path);
+        unmap_file((void *) data, size);
+        return -1;
+    }
+
+    // Glyph fields are built by reading the pixels under each rect, so every rect must
+    // lie inside the atlas
+    for (int i = 0; i < out->rect_count; i++) {
+        const unsigned char *r = data + rects_offset + i * 8;
+        const mu_Rect rect = mu_rect((int16_t) read_u16(r), (int16_t) read_u16(r + 2),
+                                     (int16_t) read_u16(r + 4), (int16_t) read_u16(r + 6));
+        if (rect.x < 0 || rect.y < 0 || rect.w < 0 || rect.h < 0 ||
+            rect.x + rect.w > out->width || rect.y + rect.h > out->height) {
+            fprintf(stderr, "Atlas rect %d lies outside the atlas: %s\n", i, path);
+            unmap_file((void *) data, size);
+            return -1;
+        }
+        out->rects[i] = rect;
+    }
+
+    if (flags & ATLAS_FLAG_RLE) {
+        // Decode straight out of the mapping, which is no longer needed afterwards
+        out->owned = malloc(pixel_count);
+        if (out->owned == NULL ||
+            rle_decode(data + pixels_offset, pixel_bytes, out->owned, pixel_count) != 0) {
+            fprintf(stderr, "Failed to decode atlas pixels: %s\n", path);
+            free(out->owned);
+            out->owned = NULL;
+            unmap_file((void *) data, size);
+            return -1;
+        }
+        out->pixels = out->owned;
+        unmap_file((void *) data, size);
+    } else {
+        // Raw pixels are used in place; the mapping lives until atlas_release_pixels
+        out->pixels = data + pixels_offset;
+        out->mapping = (void *) data;
+        out->mapping_size = size;
+    }
+    return 0;
+}
+
+int atlas_save(const Atlas *src, const char *path, const int flags) {
+    const size_t pixel_count = (size_t) src->width * src->height;
+    // Worst case RLE output, see the packet description at the top
+    unsigned char *payload = malloc(pixel_count + pixel_count / RLE_MAX_LITERAL + 1);
+    if (payload == NULL) { return -1; }
+
+    size_t pixel_bytes = pixel_count;
+    if (flags & ATLAS_FLAG_RLE) {
+        pixel_bytes = rle_encode(src->pixels, pixel_count, payload);
+    } else {
+        memcpy(payload, src->pixels, pixel_count);
+    }
+
+    unsigned char header[ATLAS_HEADER_SIZE];
+    memcpy(header, ATLAS_FILE_MAGIC, 4);
+    write_u16(header + 4, ATLAS_FILE_VERSION);
+    write_u16(header + 6, flags);
+    write_u16(header + 8, src->width);
+    write_u16(header + 10, src->height);
+    write_u16(header + 12, src->line_height);
+    write_u16(header + 14, src->rect_count);
+    write_u32(header + 16, pixel_bytes);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        free(payload);
+        return -1;
+    }
+
+    int ok = fwrite(header, sizeof(header), 1, file) == 1;
+    for (int i = 0; ok && i < src->rect_count; i++) {
+        unsigned char r[8];
+        write_u16(r, (uint16_t) src->rects[i].x);
+        write_u16(r + 2, (uint16_t) src->rects[i].y);
+        write_u16(r + 4, (uint16_t) src->rects[i].w);
+        write_u16(r + 6, (uint16_t) src->rects[i].h);
+        ok = fwrite(r, sizeof(r), 1, file) == 1;
+    }
+    ok = ok && fwrite(payload, 1, pixel_bytes, file) == pixel_bytes;
+    ok = (fclose(file) == 0) && ok;
+    free(payload);
+
+    if (!ok) {
+        fprintf(stderr, "Failed to write atlas file %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Squared distance from every sample to the nearest zero of f along one row or column, as
+// the lower envelope of parabolas (Felzenszwalb and Huttenlocher)
+static void distance_1d(const float *f, const int n, float *d, int *v, float *z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -SDF_INFINITY;
+    z[1] = SDF_INFINITY;
+    for (int q = 1; q < n; q++) {
+        float s;
+        while ((s = ((f[q] + (float) q * q) - (f[v[k]] + (float) v[k] * v[k])) / (float) (2 * (q - v[k]))) <= z[k]) {
+            k--;
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = SDF_INFINITY;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) { k++; }
+        d[q] = (float) (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+typedef struct {
+    float *outside;
+    float *inside;
+    float *f;
+    float *d;
+    float *z;
+    int *v;
+} SdfScratch;
+
+static void distance_2d(float *grid, const int w, const int h, const SdfScratch *s) {
+    for (int x = 0; x < w; x++) {
+        for (int y = 0; y < h; y++) { s->f[y] = grid[y * w + x]; }
+        distance_1d(s->f, h, s->d, s->v, s->z);
+        for (int y = 0; y < h; y++) { grid[y * w + x] = s->d[y]; }
+    }
+    for (int y = 0; y < h; y++) {
+        distance_1d(grid + y * w, w, s->d, s->v, s->z);
+        memcpy(grid + y * w, s->d, w * sizeof(float));
+    }
+}
+
+static int glyph_alpha(const Atlas *src, const mu_Rect r, const int x, const int y) {
+    if (x < 0 || y < 0 || x >= r.w || y >= r.h) { return 0; }
+    return src->pixels[(r.y + y) * src->width + r.x + x];
+}
+
+// The font is antialiased, so coverage is interpolated before thresholding; that recovers
+// outlines finer than the glyph's pixel grid
+static int glyph_ink(const Atlas *src, const mu_Rect r, const int x, const int y) {
+    const float u = (x + 0.5f) / ATLAS_SDF_UPSCALE - 0.5f, v = (y + 0.5f) / ATLAS_SDF_UPSCALE - 0.5f;
+    const int x0 = (int) floorf(u), y0 = (int) floorf(v);
+    const float fx = u - x0, fy = v - y0;
+    const float top = glyph_alpha(src, r, x0, y0) * (1 - fx) + glyph_alpha(src, r, x0 + 1, y0) * fx;
+    const float bottom = glyph_alpha(src, r, x0, y0 + 1) * (1 - fx) + glyph_alpha(src, r, x0 + 1, y0 + 1) * fx;
+    return top * (1 - fy) + bottom * fy >= 128;
+}
+
+static void build_glyph_field(const Atlas *src, const mu_Rect r, unsigned char *out, const SdfScratch *s) {
+    const int w = r.w * ATLAS_SDF_UPSCALE, h = r.h * ATLAS_SDF_UPSCALE;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            const int ink = glyph_ink(src, r, x, y);
+            s->outside[y * w + x] = ink ? 0 : SDF_INFINITY;
+            s->inside[y * w + x] = ink ? SDF_INFINITY : 0;
+        }
+    }
+    distance_2d(s->outside, w, h, s);
+    distance_2d(s->inside, w, h, s);
+
+    // Distances run between texel centres; the edge sits half a texel from both
+    const int stride = src->width * ATLAS_SDF_UPSCALE;
+    unsigned char *dst = out + (size_t) r.y * ATLAS_SDF_UPSCALE * stride + r.x * ATLAS_SDF_UPSCALE;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            const float distance = s->outside[y * w + x] == 0 ? sqrtf(s->inside[y * w + x]) - 0.5f
+                                                             : 0.5f - sqrtf(s->outside[y * w + x]);
+            const float value = 128.0f + distance * 128.0f / ATLAS_SDF_SPREAD;
+            dst[y * stride + x] = (unsigned char) (value < 0 ? 0 : value > 255 ? 255 : value + 0.5f);
+        }
+    }
+}
+
+unsigned char *atlas_build_glyph_sdf(const Atlas *src) {
+    if (src->pixels == NULL) { return NULL; }
+
+    // Each glyph gets its own field so neighbouring glyphs never bleed into it
+    int cell_w = 0, cell_h = 0;
+    const int last = mu_min(ATLAS_FONT + ATLAS_GLYPH_COUNT, src->rect_count);
+    for (int i = ATLAS_FONT; i < last; i++) {
+        cell_w = mu_max(cell_w, src->rects[i].w * ATLAS_SDF_UPSCALE);
+        cell_h = mu_max(cell_h, src->rects[i].h * ATLAS_SDF_UPSCALE);
+    }
+    const int line = mu_max(cell_w, cell_h);
+
+    unsigned char *out = calloc((size_t) src->width * ATLAS_SDF_UPSCALE * src->height * ATLAS_SDF_UPSCALE, 1);
+    SdfScratch s = {
+        .outside = malloc((size_t) cell_w * cell_h * sizeof(float)),
+        .inside = malloc((size_t) cell_w * cell_h * sizeof(float)),
+        .f = malloc(line * sizeof(float)),
+        .d = malloc(line * sizeof(float)),
+        .z = malloc((line + 1) * sizeof(float)),
+        .v = malloc(line * sizeof(int)),
+    };
+    if (out != NULL && s.outside != NULL && s.inside != NULL && s.f != NULL && s.d != NULL && s.z != NULL &&
+        s.v != NULL) {
+        for (int i = ATLAS_FONT; i < last; i++) {
+            if (src->rects[i].w > 0 && src->rects[i].h > 0) { build_glyph_field(src, src->rects[i], out, &s); }
+        }
+    } else {
+        free(out);
+        out = NULL;
+    }
+
+    free(s.outside);
+    free(s.inside);
+    free(s.f);
+    free(s.d);
+    free(s.z);
+    free(s.v);
+    return out;
+}
+
+void atlas_release_pixels(Atlas *loaded) {
+    free(loaded->owned);
+    if (loaded->mapping) {
+        unmap_file(loaded->mapping, loaded->mapping_size);
+    }
+    loaded->owned = NULL;
+    loaded->mapping = NULL;
+    loaded->mapping_size = 0;
+    loaded->pixels = NULL;
+}
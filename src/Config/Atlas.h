@@ -0,0 +1,52 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <stddef.h>
+#include "microui.h"
+
+#define ATLAS_FILE_MAGIC "SFAT"
+#define ATLAS_FILE_VERSION 1
+#define ATLAS_FILE_NAME "atlas.sfa"
+#define ATLAS_MAX_RECTS 512
+
+enum { ATLAS_WHITE = MU_ICON_MAX, ATLAS_FONT, ATLAS_GLYPH_COUNT = 128 };
+enum { ATLAS_MIN_RECTS = ATLAS_FONT + ATLAS_GLYPH_COUNT };
+
+enum {
+    ATLAS_FLAG_RLE = (1 << 0)
+};
+
+// Alpha atlas with its rects: icons at MU_ICON_*, a white texel block at ATLAS_WHITE and
+// printable glyphs at ATLAS_FONT + chr. pixels either point into a file mapping, into an
+// owned decode buffer, or at the embedded fallback.
+typedef struct {
+    int width;
+    int height;
+    int line_height;
+    int rect_count;
+    mu_Rect rects[ATLAS_MAX_RECTS];
+    const unsigned char *pixels;
+
+    unsigned char *owned;
+    void *mapping;
+    size_t mapping_size;
+} Atlas;
+
+void atlas_load_embedded(Atlas *out);
+
+int atlas_load(Atlas *out, const char *path);
+
+int atlas_save(const Atlas *src, const char *path, int flags);
+
+// Glyph distance field: ATLAS_SDF_UPSCALE times the atlas size with the same normalized
+// glyph rects, edges at 128 and ATLAS_SDF_SPREAD texels of distance on either side of
+// them. Needs the pixels, so build it before atlas_release_pixels; the caller frees it.
+#define ATLAS_SDF_UPSCALE 4
+#define ATLAS_SDF_SPREAD 4
+
+unsigned char *atlas_build_glyph_sdf(const Atlas *src);
+
+// Drops the pixel storage (decode buffer or mapping) but keeps the metrics
+void atlas_release_pixels(Atlas *loaded);
+
+#endif
@@ -0,0 +1,189 @@
+#include "src/Config/CommandBuffer.h"
+#include "src/Config/LayerCache.h"
+#include "src/Config/Renderer.h"
+#include "src/Systems/AllocTracker.h"
+#include <stddef.h>
+#include <string.h>
+
+void command_buffer_capture(CommandBuffer *buf, mu_Context *ctx) {
+    // Commands are copied in the order the jumps chain them so the buffer can be walked
+    // linearly; the total never exceeds the command list it came from. MicroUI links root
+    // containers together with jumps, so every jump taken starts a new segment.
+    buf->size = 0;
+    buf->segment_count = 0;
+    int new_segment = 1;
+    const char *end = ctx->command_list.items + ctx->command_list.idx;
+    for (const char *p = ctx->command_list.items; p != end;) {
+        const mu_Command *cmd = (const mu_Command *) p;
+        if (cmd->type == MU_COMMAND_JUMP) {
+            p = cmd->jump.dst;
+            new_segment = 1;
+            continue;
+        }
+
+        if (new_segment && buf->segment_count < COMMAND_BUFFER_MAX_SEGMENTS) {
+            buf->segments[buf->segment_count++] = buf->size;
+        }
+        new_segment = 0;
+
+        // MicroUI sizes text commands to the string, so they are padded out to keep every
+        // command aligned
+        const int size = (cmd->base.size + COMMAND_ALIGN - 1) / COMMAND_ALIGN * COMMAND_ALIGN;
+        if (size > (int) sizeof(buf->commands) - buf->size) { break; }
+
+        char *dst = buf->commands + buf->size;
+        memcpy(dst, cmd, cmd->base.size);
+        size_t used = cmd->base.size;
+        if (cmd->type == MU_COMMAND_TEXT) {
+            // MicroUI leaves the bytes past the terminator uninitialized; zero them so equal
+            // frames are byte-identical
+            used = offsetof(mu_TextCommand, str) + strlen(((mu_TextCommand *) dst)->str) + 1;
+        }
+        memset(dst + used, 0, size - used);
+        ((mu_Command *) dst)->base.size = size;
+        buf->size += size;
+        p += cmd->base.size;
+    }
+}
+
+// Smallest size a command of this type can have, or -1 for a type the renderer doesn't draw
+static int min_command_size(const int type) {
+    switch (type) {
+        case MU_COMMAND_CLIP:
+            return sizeof(mu_ClipCommand);
+        case MU_COMMAND_RECT:
+            return sizeof(mu_RectCommand);
+        case MU_COMMAND_ICON:
+            return sizeof(mu_IconCommand);
+        case MU_COMMAND_TEXT:
+            return offsetof(mu_TextCommand, str) + 1;
+        case COMMAND_POLYLINE:
+            return offsetof(PolylineCommand, spans);
+        default:
+            return -1;
+    }
+}
+
+int command_buffer_valid(const CommandBuffer *buf) {
+    if (buf->size < 0 || buf->size > (int) sizeof(buf->commands) ||
+        buf->segment_count < 0 || buf->segment_count > COMMAND_BUFFER_MAX_SEGMENTS ||
+        (buf->segment_count > 0 && buf->segments[0] != 0)) {
+        return 0;
+    }
+
+    int segment = 0;
+    for (int offset = 0; offset < buf->size;) {
+        while (segment < buf->segment_count && buf->segments[segment] == offset) { segment++; }
+        if (segment < buf->segment_count && buf->segments[segment] < offset) { return 0; }
+
+        const mu_Command *cmd = (const mu_Command *) (buf->commands + offset);
+        const int left = buf->size - offset;
+        if (left < (int) sizeof(mu_BaseCommand)) { return 0; }
+        const int min = min_command_size(cmd->type);
+        const int size = cmd->base.size;
+        if (min < 0 || size < min || size > left || size % COMMAND_ALIGN != 0) { return 0; }
+        if (cmd->type == MU_COMMAND_TEXT &&
+            memchr(cmd->text.str, '\0', size - offsetof(mu_TextCommand, str)) == NULL) {
+            return 0;
+        }
+        if (cmd->type == COMMAND_POLYLINE) {
+            const int columns = ((const PolylineCommand *) cmd)->columns;
+            if (columns < 0 || columns > COMMAND_POLYLINE_MAX_COLUMNS ||
+                (int) offsetof(PolylineCommand, spans) + 2 * (int) sizeof(short) * columns > size) {
+                return 0;
+            }
+        }
+        offset += size;
+    }
+
+    // Segments past the last command may only be empty ones at the end
+    for (; segment < buf->segment_count; segment++) {
+        if (buf->segments[segment] != buf->size) { return 0; }
+    }
+    return 1;
+}
+
+int command_buffer_segment_size(const CommandBuffer *buf, const int segment) {
+    const int end = segment + 1 < buf->segment_count ? buf->segments[segment + 1] : buf->size;
+    return end - buf->segments[segment];
+}
+
+// Recognizes the four edge rects mu_draw_box emits for an unclipped box. Clipped boxes
+// don't match and are drawn as the plain rects they are.
+static int match_box(const char *p, const char *end, mu_Rect *box, mu_Color *color) {
+    const mu_RectCommand *edges[4];
+    for (int i = 0; i < 4; i++) {
+        if (end - p < (long) sizeof(mu_RectCommand)) { return 0; }
+        edges[i] = (const mu_RectCommand *) p;
+        if (edges[i]->base.type != MU_COMMAND_RECT ||
+            memcmp(&edges[i]->color, &edges[0]->color, sizeof(mu_Color)) != 0) {
+            return 0;
+        }
+        p += edges[i]->base.size;
+    }
+
+    const mu_Rect left = edges[2]->rect, right = edges[3]->rect;
+    const mu_Rect r = mu_rect(left.x, left.y, right.x - left.x + 1, left.h);
+    const mu_Rect top = edges[0]->rect, bottom = edges[1]->rect;
+    if (left.w != 1 || right.w != 1 || right.y != r.y || right.h != r.h ||
+        top.x != r.x + 1 || top.y != r.y || top.w != r.w - 2 || top.h != 1 ||
+        bottom.x != r.x + 1 || bottom.y != r.y + r.h - 1 || bottom.w != r.w - 2 || bottom.h != 1) {
+        return 0;
+    }
+
+    *box = r;
+    *color = edges[0]->color;
+    return 1;
+}
+
+void command_buffer_render(const CommandBuffer *buf) {
+    const char *region = alloc_tracker_enter("render_commands");
+    r_begin_frame(buf->width, buf->height, buf->scale);
+    r_clear(buf->clear);
+
+    if (buf->segment_count == 0) {
+        command_buffer_render_span(buf, 0, buf->size);
+    }
+    for (int i = 0; i < buf->segment_count; i++) {
+        if (!layer_cache_draw(buf, i)) {
+            command_buffer_render_span(buf, buf->segments[i], buf->segments[i] + command_buffer_segment_size(buf, i));
+        }
+    }
+    alloc_tracker_leave(region);
+}
+
+void command_buffer_render_span(const CommandBuffer *buf, const int begin, const int end) {
+    for (int offset = begin; offset < end;) {
+        const mu_Command *cmd = (const mu_Command *) (buf->commands + offset);
+        switch (cmd->type) {
+            case MU_COMMAND_TEXT:
+                r_draw_text(cmd->text.font, cmd->text.str, cmd->text.pos, cmd->text.color);
+                break;
+            case MU_COMMAND_RECT: {
+                mu_Rect box;
+                mu_Color color;
+                if (match_box(buf->commands + offset, buf->commands + end, &box, &color)) {
+                    r_draw_box(box, color);
+                    offset += 4 * cmd->base.size;
+                    continue;
+                }
+                r_draw_rect(cmd->rect.rect, cmd->rect.color);
+                break;
+            }
+            case MU_COMMAND_ICON:
+                r_draw_icon(cmd->icon.id, cmd->icon.rect, cmd->icon.color);
+                break;
+            case MU_COMMAND_CLIP:
+                r_set_clip_rect(cmd->clip.rect);
+                break;
+            case COMMAND_POLYLINE: {
+                const PolylineCommand *line = (const PolylineCommand *) cmd;
+                r_draw_polyline(line->rect, line->spans, line->columns, line->color, line->fill);
+                break;
+            }
+            default:
+                break;
+        }
+        offset += cmd->base.size;
+    }
+}
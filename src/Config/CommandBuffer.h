@@ -0,0 +1,63 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include "microui.h"
+
+// One segment per root container, plus one for anything drawn outside them
+#define COMMAND_BUFFER_MAX_SEGMENTS (MU_ROOTLIST_SIZE + 1)
+
+// Every command in a CommandBuffer starts at a multiple of this
+#define COMMAND_ALIGN ((int) _Alignof(mu_Command))
+
+// Command types of our own, numbered after MicroUI's
+enum {
+    COMMAND_POLYLINE = MU_COMMAND_MAX
+};
+
+// Most columns a polyline may have
+#define COMMAND_POLYLINE_MAX_COLUMNS 2048
+
+// A line drawn one pixel column at a time over rect. Column i covers rows spans[2 * i] to
+// spans[2 * i + 1] (inclusive, relative to rect.y); a column whose top is below its bottom
+// is left empty. When fill is not transparent, the rows under each column's span down to
+// the bottom of rect are filled with it. base.size covers the spans, rounded up so the
+// next command stays aligned.
+typedef struct {
+    mu_BaseCommand base;
+    mu_Rect rect;
+    mu_Color color;
+    mu_Color fill;
+    int columns;
+    short spans[];
+} PolylineCommand;
+
+// A frame's MicroUI commands flattened into draw order (jumps resolved), plus everything
+// the renderer needs to draw it without touching the mu_Context. Segment i spans
+// commands[segments[i]] up to segments[i + 1] (or size for the last one). Command sizes are
+// rounded up to COMMAND_ALIGN as they are captured.
+typedef struct {
+    int width;
+    int height;
+    int scale;
+    mu_Color clear;
+    int size;
+    int segment_count;
+    int segments[COMMAND_BUFFER_MAX_SEGMENTS];
+    _Alignas(mu_Command) char commands[MU_COMMANDLIST_SIZE];
+} CommandBuffer;
+
+void command_buffer_capture(CommandBuffer *buf, mu_Context *ctx);
+
+void command_buffer_render(const CommandBuffer *buf);
+
+// Draws the commands in [begin, end) without touching frame state
+void command_buffer_render_span(const CommandBuffer *buf, int begin, int end);
+
+int command_buffer_segment_size(const CommandBuffer *buf, int segment);
+
+// 1 if buf holds only commands the renderer knows, each at least as large as its type
+// needs, aligned, and with text terminated inside it, and every segment starts on a
+// command. Frames read from a file or the network must pass this before being drawn.
+int command_buffer_valid(const CommandBuffer *buf);
+
+#endif
@@ -0,0 +1,85 @@
+#include "src/Config/GlApi.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+#define INFO_LOG_SIZE 1024
+
+GlApi gl_api;
+
+// Tries the core name first, then the ARB/EXT spellings older drivers only export
+static void *load_any(const char *core, const char *arb, const char *ext) {
+    void *fn = SDL_GL_GetProcAddress(core);
+    if (fn == NULL && arb != NULL) { fn = SDL_GL_GetProcAddress(arb); }
+    if (fn == NULL && ext != NULL) { fn = SDL_GL_GetProcAddress(ext); }
+    return fn;
+}
+
+#define LOAD(name) (gl_api.name = load_any("gl" #name, NULL, NULL), gl_api.name != NULL)
+#define LOAD_EXT(name) (gl_api.name = load_any("gl" #name, "gl" #name "ARB", "gl" #name "EXT"), gl_api.name != NULL)
+
+void gl_api_load(void) {
+    gl_api.has_shaders =
+            LOAD(CreateShader) & LOAD(ShaderSource) & LOAD(CompileShader) & LOAD(GetShaderiv) &
+            LOAD(GetShaderInfoLog) & LOAD(DeleteShader) & LOAD(CreateProgram) & LOAD(AttachShader) &
+            LOAD(BindAttribLocation) & LOAD(LinkProgram) & LOAD(GetProgramiv) & LOAD(GetProgramInfoLog) &
+            LOAD(UseProgram) & LOAD(GetUniformLocation) & LOAD(Uniform1i) & LOAD(Uniform1f) & LOAD(Uniform2f) &
+            LOAD(EnableVertexAttribArray) & LOAD(DisableVertexAttribArray) & LOAD(VertexAttribPointer) &
+            LOAD(GenBuffers) & LOAD(BindBuffer) & LOAD(BufferData) & LOAD(ActiveTexture);
+
+    gl_api.has_instancing = gl_api.has_shaders &
+                            LOAD_EXT(VertexAttribDivisor) & LOAD_EXT(DrawArraysInstanced);
+
+    gl_api.has_framebuffers =
+            LOAD_EXT(GenFramebuffers) & LOAD_EXT(DeleteFramebuffers) & LOAD_EXT(BindFramebuffer) &
+            LOAD_EXT(FramebufferTexture2D) & LOAD_EXT(CheckFramebufferStatus) & LOAD_EXT(BlendFuncSeparate);
+}
+
+static GLuint compile_shader(const GLenum type, const char *source) {
+    const GLuint shader = gl_api.CreateShader(type);
+    gl_api.ShaderSource(shader, 1, &source, NULL);
+    gl_api.CompileShader(shader);
+
+    GLint ok = GL_FALSE;
+    gl_api.GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[INFO_LOG_SIZE];
+        gl_api.GetShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "Shader compilation failed: %s\n", log);
+        gl_api.DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint gl_api_create_program(const char *vertex_source, const char *fragment_source,
+                             const char *const *attribs, const int attrib_count) {
+    if (!gl_api.has_shaders) { return 0; }
+
+    const GLuint vs = compile_shader(GL_VERTEX_SHADER, vertex_source);
+    const GLuint fs = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+    if (vs == 0 || fs == 0) {
+        if (vs) { gl_api.DeleteShader(vs); }
+        if (fs) { gl_api.DeleteShader(fs); }
+        return 0;
+    }
+
+    const GLuint program = gl_api.CreateProgram();
+    gl_api.AttachShader(program, vs);
+    gl_api.AttachShader(program, fs);
+    for (int i = 0; i < attrib_count; i++) {
+        gl_api.BindAttribLocation(program, i, attribs[i]);
+    }
+    gl_api.LinkProgram(program);
+    gl_api.DeleteShader(vs);
+    gl_api.DeleteShader(fs);
+
+    GLint ok = GL_FALSE;
+    gl_api.GetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[INFO_LOG_SIZE];
+        gl_api.GetProgramInfoLog(program, sizeof(log), NULL, log);
+        fprintf(stderr, "Shader program link failed: %s\n", log);
+        return 0;
+    }
+    return program;
+}
@@ -0,0 +1,58 @@
+#ifndef GL_API_H
+#define GL_API_H
+
+#include <SDL2/SDL_opengl.h>
+
+// GL entry points beyond 1.1 that are only reachable through SDL_GL_GetProcAddress. Each
+// group is usable only when its has_* flag is set.
+typedef struct {
+    int has_shaders;
+    PFNGLCREATESHADERPROC CreateShader;
+    PFNGLSHADERSOURCEPROC ShaderSource;
+    PFNGLCOMPILESHADERPROC CompileShader;
+    PFNGLGETSHADERIVPROC GetShaderiv;
+    PFNGLGETSHADERINFOLOGPROC GetShaderInfoLog;
+    PFNGLDELETESHADERPROC DeleteShader;
+    PFNGLCREATEPROGRAMPROC CreateProgram;
+    PFNGLATTACHSHADERPROC AttachShader;
+    PFNGLBINDATTRIBLOCATIONPROC BindAttribLocation;
+    PFNGLLINKPROGRAMPROC LinkProgram;
+    PFNGLGETPROGRAMIVPROC GetProgramiv;
+    PFNGLGETPROGRAMINFOLOGPROC GetProgramInfoLog;
+    PFNGLUSEPROGRAMPROC UseProgram;
+    PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+    PFNGLUNIFORM1IPROC Uniform1i;
+    PFNGLUNIFORM1FPROC Uniform1f;
+    PFNGLUNIFORM2FPROC Uniform2f;
+    PFNGLENABLEVERTEXATTRIBARRAYPROC EnableVertexAttribArray;
+    PFNGLDISABLEVERTEXATTRIBARRAYPROC DisableVertexAttribArray;
+    PFNGLVERTEXATTRIBPOINTERPROC VertexAttribPointer;
+    PFNGLGENBUFFERSPROC GenBuffers;
+    PFNGLBINDBUFFERPROC BindBuffer;
+    PFNGLBUFFERDATAPROC BufferData;
+    PFNGLACTIVETEXTUREPROC ActiveTexture;
+
+    int has_instancing;
+    PFNGLVERTEXATTRIBDIVISORARBPROC VertexAttribDivisor;
+    PFNGLDRAWARRAYSINSTANCEDARBPROC DrawArraysInstanced;
+
+    int has_framebuffers;
+    PFNGLGENFRAMEBUFFERSPROC GenFramebuffers;
+    PFNGLDELETEFRAMEBUFFERSPROC DeleteFramebuffers;
+    PFNGLBINDFRAMEBUFFERPROC BindFramebuffer;
+    PFNGLFRAMEBUFFERTEXTURE2DPROC FramebufferTexture2D;
+    PFNGLCHECKFRAMEBUFFERSTATUSPROC CheckFramebufferStatus;
+    PFNGLBLENDFUNCSEPARATEPROC BlendFuncSeparate;
+} GlApi;
+
+extern GlApi gl_api;
+
+// Resolves everything the current context offers; call with the context current
+void gl_api_load(void);
+
+// Compiles and links a program, binding attributes to their index in attribs. Returns 0
+// and prints the info log on failure.
+GLuint gl_api_create_program(const char *vertex_source, const char *fragment_source,
+                             const char *const *attribs, int attrib_count);
+
+#endif
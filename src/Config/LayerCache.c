@@ -0,0 +1,201 @@
+#include "src/Config/LayerCache.h"
+#include "src/Config/Renderer.h"
+#include <stdint.h>
+#include <string.h>
+
+#define LAYER_CACHE_SLOTS 8
+#define LAYER_STABLE_FRAMES 2
+#define FNV_OFFSET_BASIS 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+typedef struct {
+    uint64_t hash;
+    int layer;
+    int width;
+    int height;
+    unsigned last_used;
+} LayerEntry;
+
+typedef struct {
+    uint64_t hash;
+    int stable_frames;
+} SegmentHistory;
+
+static int enabled;
+static unsigned frame;
+static LayerEntry entries[LAYER_CACHE_SLOTS];
+static SegmentHistory history[COMMAND_BUFFER_MAX_SEGMENTS];
+
+static uint64_t hash_int(uint64_t h, const int v) {
+    for (int i = 0; i < 4; i++) {
+        h ^= (v >> (i * 8)) & 0xff;
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+static uint64_t hash_rect(uint64_t h, const mu_Rect r, const int dx, const int dy) {
+    h = hash_int(h, r.x - dx);
+    h = hash_int(h, r.y - dy);
+    h = hash_int(h, r.w);
+    return hash_int(h, r.h);
+}
+
+static uint64_t hash_color(const uint64_t h, const mu_Color c) {
+    return hash_int(h, c.r | (c.g << 8) | (c.b << 16) | (c.a << 24));
+}
+
+static mu_Rect intersect(const mu_Rect a, const mu_Rect b) {
+    const int x1 = mu_max(a.x, b.x), y1 = mu_max(a.y, b.y);
+    const int x2 = mu_min(a.x + a.w, b.x + b.w), y2 = mu_min(a.y + a.h, b.y + b.h);
+    return mu_rect(x1, y1, mu_max(x2 - x1, 0), mu_max(y2 - y1, 0));
+}
+
+static mu_Rect merge(const mu_Rect a, const mu_Rect b) {
+    if (a.w <= 0 || a.h <= 0) { return b; }
+    if (b.w <= 0 || b.h <= 0) { return a; }
+    const int x1 = mu_min(a.x, b.x), y1 = mu_min(a.y, b.y);
+    const int x2 = mu_max(a.x + a.w, b.x + b.w), y2 = mu_max(a.y + a.h, b.y + b.h);
+    return mu_rect(x1, y1, x2 - x1, y2 - y1);
+}
+
+// MicroUI's unclipped_rect starts at 0, so it counts as no clip at all; content left of or
+// above the screen keeps its size
+static mu_Rect clip_rect(const mu_Rect r, const mu_Rect clip) {
+    return clip.w >= R_UNCLIPPED_SIZE ? r : intersect(r, clip);
+}
+
+// Computes what a segment covers, unclipped by the screen, and a hash of its commands
+// relative to that area, so moving a container (even partly off screen) doesn't change its key
+static uint64_t analyze(const CommandBuffer *buf, const int begin, const int end, mu_Rect *bounds) {
+    mu_Rect clip = mu_rect(0, 0, R_UNCLIPPED_SIZE, R_UNCLIPPED_SIZE);
+    *bounds = mu_rect(0, 0, 0, 0);
+    for (int offset = begin; offset < end;) {
+        const mu_Command *cmd = (const mu_Command *) (buf->commands + offset);
+        switch (cmd->type) {
+            case MU_COMMAND_CLIP:
+                clip = cmd->clip.rect;
+                break;
+            case MU_COMMAND_RECT:
+                *bounds = merge(*bounds, clip_rect(cmd->rect.rect, clip));
+                break;
+            case MU_COMMAND_ICON:
+                *bounds = merge(*bounds, clip_rect(cmd->icon.rect, clip));
+                break;
+            case COMMAND_POLYLINE:
+                *bounds = merge(*bounds, clip_rect(((const PolylineCommand *) cmd)->rect, clip));
+                break;
+            case MU_COMMAND_TEXT: {
+                const mu_Rect r = mu_rect(cmd->text.pos.x, cmd->text.pos.y, r_measure_text(cmd->text.font, cmd->text.str, buf->scale),
+                                          r_get_line_height(cmd->text.font, buf->scale));
+                *bounds = merge(*bounds, clip_rect(r, clip));
+                break;
+            }
+            default:
+                break;
+        }
+        offset += cmd->base.size;
+    }
+
+    const int dx = bounds->x, dy = bounds->y;
+    uint64_t h = hash_int(hash_int(hash_int(FNV_OFFSET_BASIS, buf->scale), bounds->w), bounds->h);
+    for (int offset = begin; offset < end;) {
+        const mu_Command *cmd = (const mu_Command *) (buf->commands + offset);
+        h = hash_int(h, cmd->type);
+        switch (cmd->type) {
+            case MU_COMMAND_CLIP:
+                h = cmd->clip.rect.w >= R_UNCLIPPED_SIZE ? hash_rect(h, cmd->clip.rect, 0, 0)
+                                                         : hash_rect(h, cmd->clip.rect, dx, dy);
+                break;
+            case MU_COMMAND_RECT:
+                h = hash_color(hash_rect(h, cmd->rect.rect, dx, dy), cmd->rect.color);
+                break;
+            case MU_COMMAND_ICON:
+                h = hash_color(hash_int(hash_rect(h, cmd->icon.rect, dx, dy), cmd->icon.id), cmd->icon.color);
+                break;
+            case MU_COMMAND_TEXT:
+                h = hash_color(hash_rect(h, mu_rect(cmd->text.pos.x, cmd->text.pos.y, 0, 0), dx, dy), cmd->text.color);
+                h = hash_int(h, (int) (intptr_t) cmd->text.font);
+                for (const char *p = cmd->text.str; *p; p++) {
+                    h = (h ^ (unsigned char) *p) * FNV_PRIME;
+                }
+                break;
+            case COMMAND_POLYLINE: {
+                const PolylineCommand *line = (const PolylineCommand *) cmd;
+                h = hash_color(hash_color(hash_rect(h, line->rect, dx, dy), line->color), line->fill);
+                h = hash_int(h, line->columns);
+                const unsigned char *spans = (const unsigned char *) line->spans;
+                for (size_t i = 0; i < 2 * sizeof(short) * line->columns; i++) {
+                    h = (h ^ spans[i]) * FNV_PRIME;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        offset += cmd->base.size;
+    }
+    return h;
+}
+
+void layer_cache_set_enabled(const int on) {
+    enabled = on && r_layers_supported();
+    if (!enabled) {
+        for (int i = 0; i < LAYER_CACHE_SLOTS; i++) {
+            if (entries[i].width > 0) { r_layer_destroy(entries[i].layer); }
+        }
+        memset(entries, 0, sizeof(entries));
+    }
+}
+
+int layer_cache_draw(const CommandBuffer *buf, const int segment) {
+    if (!enabled) { return 0; }
+    if (segment == 0) { frame++; }
+
+    const int begin = buf->segments[segment];
+    const int end = begin + command_buffer_segment_size(buf, segment);
+    mu_Rect bounds;
+    const uint64_t hash = analyze(buf, begin, end, &bounds);
+    // Off screen, or too large for a layer; the composite clips whatever lies past the edges
+    const mu_Rect visible = intersect(bounds, mu_rect(0, 0, buf->width, buf->height));
+    if (visible.w <= 0 || visible.h <= 0 || bounds.w > R_MAX_LAYER_SIZE || bounds.h > R_MAX_LAYER_SIZE) { return 0; }
+
+    SegmentHistory *hist = &history[segment];
+    hist->stable_frames = hist->hash == hash ? hist->stable_frames + 1 : 0;
+    hist->hash = hash;
+
+    for (int i = 0; i < LAYER_CACHE_SLOTS; i++) {
+        LayerEntry *entry = &entries[i];
+        if (entry->width > 0 && entry->hash == hash) {
+            entry->last_used = frame;
+            r_layer_draw(entry->layer, bounds.x, bounds.y, 1.0f);
+            return 1;
+        }
+    }
+
+    // Content that changes every frame would pay for a rasterization and a composite
+    if (hist->stable_frames < LAYER_STABLE_FRAMES) { return 0; }
+
+    LayerEntry *victim = &entries[0];
+    for (int i = 1; i < LAYER_CACHE_SLOTS && victim->width > 0; i++) {
+        if (entries[i].width == 0 || entries[i].last_used < victim->last_used) { victim = &entries[i]; }
+    }
+    if (victim->width > 0 && victim->last_used == frame) { return 0; }
+
+    if (victim->width != bounds.w || victim->height != bounds.h) {
+        if (victim->width > 0) { r_layer_destroy(victim->layer); }
+        victim->width = 0;
+        victim->layer = r_layer_create(bounds.w, bounds.h);
+        if (victim->layer < 0) { return 0; }
+        victim->width = bounds.w;
+        victim->height = bounds.h;
+    }
+    victim->hash = hash;
+    victim->last_used = frame;
+
+    r_layer_begin(victim->layer, bounds.x, bounds.y);
+    command_buffer_render_span(buf, begin, end);
+    r_layer_end();
+    r_layer_draw(victim->layer, bounds.x, bounds.y, 1.0f);
+    return 1;
+}
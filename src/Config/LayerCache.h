@@ -0,0 +1,15 @@
+#ifndef LAYER_CACHE_H
+#define LAYER_CACHE_H
+
+#include "src/Config/CommandBuffer.h"
+
+// Caches root containers (command buffer segments) as offscreen layers. A segment is keyed
+// by a hash of its commands taken relative to its bounds, so a window that only moves, like
+// the sliding menu, keeps hitting the same layer and costs one textured quad per frame.
+void layer_cache_set_enabled(int enabled);
+
+// Draws a segment from its layer, rasterizing it into one first once its content has been
+// stable for a few frames. Returns 0 if the caller should draw the segment directly.
+int layer_cache_draw(const CommandBuffer *buf, int segment);
+
+#endif
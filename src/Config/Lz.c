@@ -0,0 +1,124 @@
+#include "src/Config/Lz.h"
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * A stream of sequences, each made of:
+ *   uint8    token         literal count in the high nibble, match length - 4 in the low one
+ *   uint8    extra[]       when a nibble is 15, further bytes are added until one is < 255
+ *   uint8    literals[]
+ *   uint16   offset        little-endian distance back to the match; absent in the last sequence
+ *   uint8    extra[]       match length continuation
+ */
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 12
+#define LZ_NIBBLE_MAX 15
+
+static uint32_t read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static unsigned hash32(const uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static unsigned char *write_length(unsigned char *op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (unsigned char) length;
+    return op;
+}
+
+static unsigned char *emit(unsigned char *op, const unsigned char *literals, const size_t literal_count,
+                           const size_t offset, const size_t match_length) {
+    unsigned char *token = op++;
+    *token = (literal_count >= LZ_NIBBLE_MAX ? LZ_NIBBLE_MAX : literal_count) << 4;
+    if (literal_count >= LZ_NIBBLE_MAX) { op = write_length(op, literal_count - LZ_NIBBLE_MAX); }
+    memcpy(op, literals, literal_count);
+    op += literal_count;
+
+    if (match_length == 0) { return op; }
+
+    *op++ = offset & 0xff;
+    *op++ = (offset >> 8) & 0xff;
+    const size_t extra = match_length - LZ_MIN_MATCH;
+    *token |= extra >= LZ_NIBBLE_MAX ? LZ_NIBBLE_MAX : extra;
+    if (extra >= LZ_NIBBLE_MAX) { op = write_length(op, extra - LZ_NIBBLE_MAX); }
+    return op;
+}
+
+size_t lz_compress(const unsigned char *src, const size_t size, unsigned char *dst) {
+    // Positions are stored +1 so a zeroed table means "no candidate"
+    uint32_t table[1 << LZ_HASH_BITS] = {0};
+    unsigned char *op = dst;
+    size_t anchor = 0, ip = 0;
+
+    while (ip + LZ_MIN_MATCH <= size) {
+        const uint32_t sequence = read32(src + ip);
+        const unsigned h = hash32(sequence);
+        const size_t candidate = table[h];
+        table[h] = (uint32_t) ip + 1;
+
+        if (candidate == 0 || ip - (candidate - 1) > LZ_MAX_OFFSET || read32(src + candidate - 1) != sequence) {
+            ip++;
+            continue;
+        }
+
+        const size_t ref = candidate - 1;
+        size_t length = LZ_MIN_MATCH;
+        while (ip + length < size && src[ref + length] == src[ip + length]) { length++; }
+
+        op = emit(op, src + anchor, ip - anchor, ip - ref, length);
+        ip += length;
+        anchor = ip;
+    }
+
+    return emit(op, src + anchor, size - anchor, 0, 0) - dst;
+}
+
+static int read_length(const unsigned char **ip, const unsigned char *end, size_t *length) {
+    unsigned char b;
+    do {
+        if (*ip >= end) { return -1; }
+        b = *(*ip)++;
+        *length += b;
+    } while (b == 255);
+    return 0;
+}
+
+long lz_decompress(const unsigned char *src, const size_t size, unsigned char *dst, const size_t capacity) {
+    const unsigned char *ip = src, *end = src + size;
+    size_t out = 0;
+
+    while (ip < end) {
+        const unsigned token = *ip++;
+        size_t literal_count = token >> 4;
+        if (literal_count == LZ_NIBBLE_MAX && read_length(&ip, end, &literal_count) != 0) { return -1; }
+        if (literal_count > (size_t) (end - ip) || literal_count > capacity - out) { return -1; }
+        memcpy(dst + out, ip, literal_count);
+        ip += literal_count;
+        out += literal_count;
+
+        // The final sequence carries literals only
+        if (ip == end) { break; }
+
+        if (end - ip < 2) { return -1; }
+        const size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        size_t length = token & LZ_NIBBLE_MAX;
+        if (length == LZ_NIBBLE_MAX && read_length(&ip, end, &length) != 0) { return -1; }
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > out || length > capacity - out) { return -1; }
+
+        // Byte by byte, since matches may overlap the bytes they produce
+        for (size_t i = 0; i < length; i++, out++) {
+            dst[out] = dst[out - offset];
+        }
+    }
+    return (long) out;
+}
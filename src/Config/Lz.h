@@ -0,0 +1,16 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <stddef.h>
+
+// Worst-case compressed size for n input bytes
+#define LZ_BOUND(n) ((n) + (n) / 255 + 16)
+
+// Byte-oriented LZ77 in the spirit of LZ4: fast enough to run on every frame and good at
+// the repetitive layouts of command lists. Returns the compressed size.
+size_t lz_compress(const unsigned char *src, size_t size, unsigned char *dst);
+
+// Returns the decompressed size, or -1 if the input is malformed or doesn't fit
+long lz_decompress(const unsigned char *src, size_t size, unsigned char *dst, size_t capacity);
+
+#endif
@@ -0,0 +1,465 @@
+#include "src/Config/RemoteDisplay.h"
+#include "src/Config/Lz.h"
+#include "src/Systems/AllocTracker.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Each message is an 8-byte header (uint32 compressed size, uint32 raw size) followed by
+ * the LZ-compressed frame:
+ *   uint16   width, height, scale
+ *   uint8    clear[4]
+ *   uint16   segment_count
+ *   per segment, one of
+ *     uint8 SEGMENT_REF      uint16 index of an identical segment in the previous frame
+ *     uint8 SEGMENT_LITERAL  uint32 size, uint8 commands[size]
+ * Frames identical to the last one sent aren't sent at all, so an idle UI costs nothing.
+ */
+#define MESSAGE_HEADER_SIZE 8
+#define FRAME_HEADER_SIZE 12
+#define SEGMENT_HEADER_MAX 5
+#define RAW_CAPACITY (FRAME_HEADER_SIZE + COMMAND_BUFFER_MAX_SEGMENTS * SEGMENT_HEADER_MAX + MU_COMMANDLIST_SIZE)
+#define MESSAGE_CAPACITY (MESSAGE_HEADER_SIZE + LZ_BOUND(RAW_CAPACITY))
+#define FNV_OFFSET_BASIS 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+enum {
+    SEGMENT_REF,
+    SEGMENT_LITERAL
+};
+
+static void write_u16(unsigned char *p, const unsigned v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void write_u32(unsigned char *p, const uint32_t v) {
+    write_u16(p, v & 0xffff);
+    write_u16(p + 2, v >> 16);
+}
+
+static unsigned read_u16(const unsigned char *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t read_u32(const unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+#ifdef _WIN32
+
+int remote_display_listen(const char *address) {
+    fprintf(stderr, "Remote display is not supported on this platform\n");
+    return -1;
+}
+
+void remote_display_send(const CommandBuffer *buf) {}
+
+void remote_display_close(void) {}
+
+RemoteViewer *remote_viewer_connect(const char *address) {
+    fprintf(stderr, "Remote display is not supported on this platform\n");
+    return NULL;
+}
+
+int remote_viewer_receive(RemoteViewer *viewer, CommandBuffer *buf, int timeout_ms) {
+    return -1;
+}
+
+void remote_viewer_close(RemoteViewer *viewer) {}
+
+#else
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+typedef struct {
+    int listen_fd;
+    int client_fd;
+    char unix_path[sizeof(((struct sockaddr_un *) 0)->sun_path)];
+
+    // Last frame the viewer has been sent, which the next one is delta-encoded against
+    int has_previous;
+    int width, height, scale;
+    mu_Color clear;
+    int segment_count;
+    uint64_t hashes[COMMAND_BUFFER_MAX_SEGMENTS];
+    int sizes[COMMAND_BUFFER_MAX_SEGMENTS];
+
+    unsigned char raw[RAW_CAPACITY];
+    unsigned char message[MESSAGE_CAPACITY];
+    size_t message_size;
+    size_t message_sent;
+} RemoteSender;
+
+struct RemoteViewer {
+    int fd;
+    unsigned char *input;
+    size_t input_size;
+    unsigned char raw[RAW_CAPACITY];
+    CommandBuffer frames[2];
+    int current;
+    int has_frame;
+};
+
+static RemoteSender *sender;
+
+static void set_socket_options(const int fd, const int tcp) {
+    if (tcp) {
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+#ifdef SO_NOSIGPIPE
+    const int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+// Opens a listening or connected stream socket for the address; unix_path receives the
+// socket path for unix addresses so the listener can unlink it again.
+static int open_socket(const char *address, const int listening, char *unix_path, const size_t unix_path_size) {
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un addr = {.sun_family = AF_UNIX};
+        const char *path = address + 5;
+        if (strlen(path) >= sizeof(addr.sun_path)) {
+            fprintf(stderr, "Socket path too long: %s\n", path);
+            return -1;
+        }
+        strcpy(addr.sun_path, path);
+
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) { return -1; }
+        set_socket_options(fd, 0);
+        if (listening) {
+            unlink(path);
+            if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(fd, 1) != 0) {
+                close(fd);
+                return -1;
+            }
+            if (unix_path != NULL) { snprintf(unix_path, unix_path_size, "%s", path); }
+        } else if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    if (strncmp(address, "tcp:", 4) != 0) {
+        fprintf(stderr, "Unknown remote address %s (expected unix:PATH or tcp:[HOST:]PORT)\n", address);
+        return -1;
+    }
+
+    char host[256] = {0};
+    const char *port = address + 4;
+    const char *colon = strrchr(port, ':');
+    if (colon != NULL) {
+        snprintf(host, sizeof(host), "%.*s", (int) (colon - port), port);
+        port = colon + 1;
+    }
+
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+    struct addrinfo *results = NULL;
+    if (getaddrinfo(host[0] ? host : NULL, port, &hints, &results) != 0) {
+        fprintf(stderr, "Failed to resolve %s\n", address);
+        return -1;
+    }
+
+    int fd = -1;
+    for (const struct addrinfo *ai = results; ai != NULL && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) { continue; }
+        set_socket_options(fd, 1);
+
+        int ok;
+        if (listening) {
+            const int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            ok = bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 1) == 0;
+        } else {
+            ok = connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+        }
+        if (!ok) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(results);
+    return fd;
+}
+
+static void set_nonblocking(const int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static uint64_t hash_bytes(const char *data, const int size) {
+    uint64_t h = FNV_OFFSET_BASIS;
+    for (int i = 0; i < size; i++) {
+        h ^= (unsigned char) data[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+int remote_display_listen(const char *address) {
+    sender = tracked_calloc(ALLOC_REMOTE, 1, sizeof(RemoteSender));
+    if (sender == NULL) { return -1; }
+
+    sender->client_fd = -1;
+    sender->listen_fd = open_socket(address, 1, sender->unix_path, sizeof(sender->unix_path));
+    if (sender->listen_fd < 0) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", address, strerror(errno));
+        tracked_free(sender);
+        sender = NULL;
+        return -1;
+    }
+    set_nonblocking(sender->listen_fd);
+    printf("Remote display listening on %s\n", address);
+    return 0;
+}
+
+static void drop_client(void) {
+    close(sender->client_fd);
+    sender->client_fd = -1;
+}
+
+// Returns 1 once the queued message has been written out completely
+static int flush_message(void) {
+    while (sender->message_sent < sender->message_size) {
+        const ssize_t n = send(sender->client_fd, sender->message + sender->message_sent,
+                               sender->message_size - sender->message_sent, SEND_FLAGS);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) { drop_client(); }
+            return 0;
+        }
+        sender->message_sent += n;
+    }
+    return 1;
+}
+
+void remote_display_send(const CommandBuffer *buf) {
+    if (sender == NULL) { return; }
+
+    if (sender->client_fd < 0) {
+        sender->client_fd = accept(sender->listen_fd, NULL, NULL);
+        if (sender->client_fd < 0) { return; }
+        set_nonblocking(sender->client_fd);
+        set_socket_options(sender->client_fd, sender->unix_path[0] == '\0');
+        sender->has_previous = 0;
+        sender->message_size = sender->message_sent = 0;
+    }
+
+    // Still busy with an earlier frame: skip this one, the next is encoded against what
+    // the viewer will actually have
+    if (!flush_message()) { return; }
+
+    uint64_t hashes[COMMAND_BUFFER_MAX_SEGMENTS];
+    int sizes[COMMAND_BUFFER_MAX_SEGMENTS];
+    int unchanged = sender->has_previous && buf->segment_count == sender->segment_count &&
+                    buf->width == sender->width && buf->height == sender->height &&
+                    buf->scale == sender->scale && memcmp(&buf->clear, &sender->clear, sizeof(mu_Color)) == 0;
+    for (int i = 0; i < buf->segment_count; i++) {
+        sizes[i] = command_buffer_segment_size(buf, i);
+        hashes[i] = hash_bytes(buf->commands + buf->segments[i], sizes[i]);
+        unchanged = unchanged && hashes[i] == sender->hashes[i] && sizes[i] == sender->sizes[i];
+    }
+    if (unchanged) { return; }
+
+    unsigned char *p = sender->raw;
+    write_u16(p, buf->width);
+    write_u16(p + 2, buf->height);
+    write_u16(p + 4, buf->scale);
+    p[6] = buf->clear.r;
+    p[7] = buf->clear.g;
+    p[8] = buf->clear.b;
+    p[9] = buf->clear.a;
+    write_u16(p + 10, buf->segment_count);
+    p += FRAME_HEADER_SIZE;
+
+    for (int i = 0; i < buf->segment_count; i++) {
+        int ref = -1;
+        for (int j = 0; sender->has_previous && j < sender->segment_count && ref < 0; j++) {
+            if (sender->hashes[j] == hashes[i] && sender->sizes[j] == sizes[i]) { ref = j; }
+        }
+
+        if (ref >= 0) {
+            *p++ = SEGMENT_REF;
+            write_u16(p, ref);
+            p += 2;
+        } else {
+            *p++ = SEGMENT_LITERAL;
+            write_u32(p, sizes[i]);
+            memcpy(p + 4, buf->commands + buf->segments[i], sizes[i]);
+            p += 4 + sizes[i];
+        }
+    }
+
+    const size_t raw_size = p - sender->raw;
+    const size_t compressed = lz_compress(sender->raw, raw_size, sender->message + MESSAGE_HEADER_SIZE);
+    write_u32(sender->message, compressed);
+    write_u32(sender->message + 4, raw_size);
+    sender->message_size = MESSAGE_HEADER_SIZE + compressed;
+    sender->message_sent = 0;
+
+    sender->has_previous = 1;
+    sender->width = buf->width;
+    sender->height = buf->height;
+    sender->scale = buf->scale;
+    sender->clear = buf->clear;
+    sender->segment_count = buf->segment_count;
+    memcpy(sender->hashes, hashes, sizeof(hashes[0]) * buf->segment_count);
+    memcpy(sender->sizes, sizes, sizeof(sizes[0]) * buf->segment_count);
+
+    flush_message();
+}
+
+void remote_display_close(void) {
+    if (sender == NULL) { return; }
+
+    if (sender->client_fd >= 0) { close(sender->client_fd); }
+    close(sender->listen_fd);
+    if (sender->unix_path[0]) { unlink(sender->unix_path); }
+    tracked_free(sender);
+    sender = NULL;
+}
+
+RemoteViewer *remote_viewer_connect(const char *address) {
+    RemoteViewer *viewer = tracked_calloc(ALLOC_REMOTE, 1, sizeof(RemoteViewer));
+    if (viewer == NULL) { return NULL; }
+
+    viewer->input = tracked_malloc(ALLOC_REMOTE, MESSAGE_CAPACITY);
+    viewer->fd = open_socket(address, 0, NULL, 0);
+    if (viewer->input == NULL || viewer->fd < 0) {
+        fprintf(stderr, "Failed to connect to %s: %s\n", address, strerror(errno));
+        tracked_free(viewer->input);
+        tracked_free(viewer);
+        return NULL;
+    }
+    set_nonblocking(viewer->fd);
+    return viewer;
+}
+
+// Rebuilds a frame from its segments, taking references from the previous frame
+static int decode_frame(RemoteViewer *viewer, const unsigned char *raw, const size_t raw_size) {
+    const CommandBuffer *previous = &viewer->frames[viewer->current];
+    CommandBuffer *frame = &viewer->frames[viewer->current ^ 1];
+    const unsigned char *p = raw, *end = raw + raw_size;
+    if (raw_size < FRAME_HEADER_SIZE) { return -1; }
+
+    frame->width = read_u16(p);
+    frame->height = read_u16(p + 2);
+    frame->scale = read_u16(p + 4);
+    frame->clear = mu_color(p[6], p[7], p[8], p[9]);
+    frame->segment_count = read_u16(p + 10);
+    frame->size = 0;
+    p += FRAME_HEADER_SIZE;
+    if (frame->segment_count > COMMAND_BUFFER_MAX_SEGMENTS) { return -1; }
+
+    for (int i = 0; i < frame->segment_count; i++) {
+        const char *src;
+        int size;
+        if (p < end && *p == SEGMENT_REF && end - p >= 3) {
+            const int ref = read_u16(p + 1);
+            if (!viewer->has_frame || ref >= previous->segment_count) { return -1; }
+            src = previous->commands + previous->segments[ref];
+            size = command_buffer_segment_size(previous, ref);
+            p += 3;
+        } else if (p < end && *p == SEGMENT_LITERAL && end - p >= 5) {
+            size = read_u32(p + 1);
+            src = (const char *) p + 5;
+            if (size < 0 || size > end - p - 5) { return -1; }
+            p += 5 + size;
+        } else {
+            return -1;
+        }
+
+        if (size > (int) sizeof(frame->commands) - frame->size) { return -1; }
+        frame->segments[i] = frame->size;
+        memcpy(frame->commands + frame->size, src, size);
+        frame->size += size;
+    }
+
+    // The frame comes from a peer and the renderer trusts every command in it
+    if (!command_buffer_valid(frame)) { return -1; }
+
+    viewer->current ^= 1;
+    viewer->has_frame = 1;
+    return 0;
+}
+
+int remote_viewer_receive(RemoteViewer *viewer, CommandBuffer *buf, const int timeout_ms) {
+    struct pollfd pfd = {.fd = viewer->fd, .events = POLLIN};
+    if (poll(&pfd, 1, timeout_ms) <= 0) { return 0; }
+
+    for (;;) {
+        const ssize_t n = recv(viewer->fd, viewer->input + viewer->input_size,
+                               MESSAGE_CAPACITY - viewer->input_size, 0);
+        if (n == 0) { return -1; }
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { break; }
+            return -1;
+        }
+        viewer->input_size += n;
+        if (viewer->input_size == MESSAGE_CAPACITY) { break; }
+    }
+
+    // Every buffered message is decoded in order since each depends on the one before;
+    // only the newest frame is handed out.
+    int decoded = 0;
+    size_t offset = 0;
+    while (viewer->input_size - offset >= MESSAGE_HEADER_SIZE) {
+        const unsigned char *message = viewer->input + offset;
+        const uint32_t compressed = read_u32(message);
+        const uint32_t raw_size = read_u32(message + 4);
+        if (compressed > MESSAGE_CAPACITY - MESSAGE_HEADER_SIZE || raw_size > RAW_CAPACITY) { return -1; }
+        if (viewer->input_size - offset < MESSAGE_HEADER_SIZE + compressed) { break; }
+
+        const long size = lz_decompress(message + MESSAGE_HEADER_SIZE, compressed, viewer->raw, RAW_CAPACITY);
+        if (size != (long) raw_size || decode_frame(viewer, viewer->raw, raw_size) != 0) { return -1; }
+        offset += MESSAGE_HEADER_SIZE + compressed;
+        decoded = 1;
+    }
+    memmove(viewer->input, viewer->input + offset, viewer->input_size - offset);
+    viewer->input_size -= offset;
+
+    if (!decoded) { return 0; }
+
+    const CommandBuffer *frame = &viewer->frames[viewer->current];
+    buf->width = frame->width;
+    buf->height = frame->height;
+    buf->scale = frame->scale;
+    buf->clear = frame->clear;
+    buf->segment_count = frame->segment_count;
+    memcpy(buf->segments, frame->segments, sizeof(frame->segments[0]) * frame->segment_count);
+    memcpy(buf->commands, frame->commands, frame->size);
+    buf->size = frame->size;
+    return 1;
+}
+
+void remote_viewer_close(RemoteViewer *viewer) {
+    if (viewer == NULL) { return; }
+    close(viewer->fd);
+    tracked_free(viewer->input);
+    tracked_free(viewer);
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef REMOTE_DISPLAY_H
+#define REMOTE_DISPLAY_H
+
+#include "src/Config/CommandBuffer.h"
+
+// Addresses are "unix:/path/to/socket" or "tcp:[host:]port". Remote display uses BSD
+// sockets and is only available on POSIX systems.
+
+// Sender side: listens for one viewer at a time and streams frames to it. Sending never
+// blocks; a frame that finds the previous one still queued is skipped.
+int remote_display_listen(const char *address);
+
+void remote_display_send(const CommandBuffer *buf);
+
+void remote_display_close(void);
+
+typedef struct RemoteViewer RemoteViewer;
+
+// Viewer side
+RemoteViewer *remote_viewer_connect(const char *address);
+
+// Waits up to timeout_ms for a frame; returns 1 when buf holds a new frame, 0 on timeout
+// and -1 once the connection is closed or the stream is corrupt.
+int remote_viewer_receive(RemoteViewer *viewer, CommandBuffer *buf, int timeout_ms);
+
+void remote_viewer_close(RemoteViewer *viewer);
+
+#endif
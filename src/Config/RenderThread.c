@@ -0,0 +1,127 @@
+#include "src/Config/RenderThread.h"
+#include "src/Config/Renderer.h"
+#include "src/Systems/AllocTracker.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FRAME_BUFFER_COUNT 3
+#define MAILBOX_INDEX_MASK 0x3
+#define MAILBOX_FRESH 0x4
+#define WAKE_TIMEOUT_MS 100
+
+/*
+ * Three buffers rotate between the UI thread (back), the mailbox and the render thread
+ * (front). Both sides swap their buffer with the mailbox in a single atomic exchange, so
+ * neither ever waits on the other: the UI thread can always write a frame while one is
+ * pending and one is being drawn, and the render thread always takes the newest frame.
+ * The mailbox value is a buffer index, with MAILBOX_FRESH set while it hasn't been taken.
+ */
+static CommandBuffer *buffers;
+static int back;
+static int front;
+static SDL_atomic_t mailbox;
+static SDL_atomic_t running;
+static SDL_sem *wake;
+static SDL_Thread *thread;
+
+// Start handshake: ready is posted once the thread owns the context (or failed to take it,
+// with status saying which), so the one-time cost is paid inside render_thread_start
+// rather than during some later frame
+typedef struct {
+    SDL_sem *ready;
+    int status;
+} StartHandshake;
+
+static int render_loop(void *data) {
+    StartHandshake *start = data;
+    const int status = r_make_current();
+    start->status = status;
+    SDL_SemPost(start->ready);
+    if (status != 0) { return -1; }
+
+    while (SDL_AtomicGet(&running)) {
+        if (!(SDL_AtomicGet(&mailbox) & MAILBOX_FRESH)) {
+            SDL_SemWaitTimeout(wake, WAKE_TIMEOUT_MS);
+            continue;
+        }
+
+        front = SDL_AtomicSet(&mailbox, front) & MAILBOX_INDEX_MASK;
+        command_buffer_render(&buffers[front]);
+        r_present();
+    }
+
+    r_release_current();
+    return 0;
+}
+
+int render_thread_start(void) {
+    buffers = tracked_calloc(ALLOC_RENDER, FRAME_BUFFER_COUNT, sizeof(CommandBuffer));
+    wake = SDL_CreateSemaphore(0);
+    SDL_sem *ready = SDL_CreateSemaphore(0);
+    if (buffers == NULL || wake == NULL || ready == NULL) {
+        fprintf(stderr, "Failed to allocate render thread resources\n");
+        if (wake) { SDL_DestroySemaphore(wake); }
+        if (ready) { SDL_DestroySemaphore(ready); }
+        tracked_free(buffers);
+        buffers = NULL;
+        return -1;
+    }
+
+    back = 0;
+    SDL_AtomicSet(&mailbox, 1);
+    front = 2;
+    SDL_AtomicSet(&running, 1);
+
+    r_release_current();
+    StartHandshake start = {ready, 0};
+    thread = SDL_CreateThread(render_loop, "render", &start);
+    if (thread == NULL) {
+        fprintf(stderr, "Failed to create render thread: %s\n", SDL_GetError());
+        SDL_DestroySemaphore(ready);
+        r_make_current();
+        SDL_DestroySemaphore(wake);
+        tracked_free(buffers);
+        buffers = NULL;
+        return -1;
+    }
+    SDL_SemWait(ready);
+    SDL_DestroySemaphore(ready);
+
+    if (start.status != 0) {
+        fprintf(stderr, "Render thread could not take the GL context: %s\n", SDL_GetError());
+        SDL_WaitThread(thread, NULL);
+        thread = NULL;
+        r_make_current();
+        SDL_DestroySemaphore(wake);
+        tracked_free(buffers);
+        buffers = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+CommandBuffer *render_thread_back_buffer(void) {
+    return &buffers[back];
+}
+
+void render_thread_publish(void) {
+    // Whatever was in the mailbox comes back as the new back buffer; if it was still
+    // fresh that frame is simply dropped in favour of this one.
+    back = SDL_AtomicSet(&mailbox, back | MAILBOX_FRESH) & MAILBOX_INDEX_MASK;
+    SDL_SemPost(wake);
+}
+
+void render_thread_stop(void) {
+    if (thread == NULL) { return; }
+
+    SDL_AtomicSet(&running, 0);
+    SDL_SemPost(wake);
+    SDL_WaitThread(thread, NULL);
+    thread = NULL;
+
+    r_make_current();
+    SDL_DestroySemaphore(wake);
+    tracked_free(buffers);
+    buffers = NULL;
+}
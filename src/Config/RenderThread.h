@@ -0,0 +1,18 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "src/Config/CommandBuffer.h"
+
+// Hands the GL context to a dedicated thread that renders published frames. The UI thread
+// fills the buffer from render_thread_back_buffer() and publishes it; publishing never
+// blocks and a frame the render thread hasn't picked up yet is replaced by the newer one.
+int render_thread_start(void);
+
+CommandBuffer *render_thread_back_buffer(void);
+
+void render_thread_publish(void);
+
+// Joins the thread and makes the GL context current on the caller again
+void render_thread_stop(void);
+
+#endif
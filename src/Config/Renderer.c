@@ -1,11 +1,19 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_opengl.h>
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "src/Config/Renderer.h"
-#include "src/Config/atlas.inl"
+#include "src/Constants.h"
+#include "src/Config/Atlas.h"
+#include "src/Config/GlApi.h"
+#include "src/Systems/Profiler.h"
 
 #define BUFFER_SIZE 16384
+#define BOX_BORDER_WIDTH 1
+#define FONT_BODY_PERCENT 100
 
 static GLfloat tex_buf[BUFFER_SIZE * 8];
 static GLfloat vert_buf[BUFFER_SIZE * 8];
@@ -14,17 +22,137 @@ static GLuint index_buf[BUFFER_SIZE * 6];
 
 static int width = 800;
 static int height = 600;
+static int scale = 1;
+static int draw_scale = 1;
 static int buf_idx;
+static Atlas atlas;
+static SDL_GLContext context;
+
+// One record per rect, glyph or icon; the vertex shader expands it into a quad. Borders
+// set border_width and have their interior discarded, so a box is a single instance.
+// Glyphs set glyph to sample the distance field instead of the atlas.
+typedef struct {
+    GLshort dst[4];
+    GLshort src[4];
+    GLubyte color[4];
+    GLshort border_width;
+    GLshort glyph;
+} Instance;
+
+enum {
+    ATTRIB_CORNER,
+    ATTRIB_DST,
+    ATTRIB_SRC,
+    ATTRIB_COLOR,
+    ATTRIB_BORDER,
+    ATTRIB_GLYPH
+};
+
+static const char *instance_attribs[] = {"corner", "dst", "src", "color", "border_width", "glyph"};
+
+static const char *instance_vertex_shader =
+        "#version 120\n"
+        "attribute vec2 corner;\n"
+        "attribute vec4 dst;\n"
+        "attribute vec4 src;\n"
+        "attribute vec4 color;\n"
+        "attribute float border_width;\n"
+        "attribute float glyph;\n"
+        "uniform vec2 viewport;\n"
+        "uniform vec2 atlas_size;\n"
+        "varying vec2 v_uv;\n"
+        "varying vec4 v_color;\n"
+        "varying vec2 v_local;\n"
+        "varying vec2 v_size;\n"
+        "varying float v_border;\n"
+        "varying float v_glyph;\n"
+        "void main() {\n"
+        "    vec2 pos = dst.xy + corner * dst.zw;\n"
+        "    gl_Position = vec4(pos.x / viewport.x * 2.0 - 1.0, 1.0 - pos.y / viewport.y * 2.0, 0.0, 1.0);\n"
+        "    v_uv = (src.xy + corner * src.zw) / atlas_size;\n"
+        "    v_color = color;\n"
+        "    v_local = corner * dst.zw;\n"
+        "    v_size = dst.zw;\n"
+        "    v_border = border_width;\n"
+        "    v_glyph = glyph;\n"
+        "}\n";
+
+static const char *instance_fragment_shader =
+        "#version 120\n"
+        "uniform sampler2D atlas;\n"
+        "uniform sampler2D glyphs;\n"
+        "varying vec2 v_uv;\n"
+        "varying vec4 v_color;\n"
+        "varying vec2 v_local;\n"
+        "varying vec2 v_size;\n"
+        "varying float v_border;\n"
+        "varying float v_glyph;\n"
+        "void main() {\n"
+        "    if (v_border > 0.0 && all(greaterThan(v_local, vec2(v_border))) &&\n"
+        "        all(lessThan(v_local, v_size - v_border))) {\n"
+        "        discard;\n"
+        "    }\n"
+        "    // 128 marks the glyph edge; smoothing over one pixel keeps it sharp at any size\n"
+        "    float d = texture2D(glyphs, v_uv).a;\n"
+        "    float w = max(0.5 * length(vec2(dFdx(d), dFdy(d))), 0.0001);\n"
+        "    float coverage = v_glyph > 0.0 ? smoothstep(0.502 - w, 0.502 + w, d) : texture2D(atlas, v_uv).a;\n"
+        "    gl_FragColor = vec4(v_color.rgb, v_color.a * coverage);\n"
+        "}\n";
+
+static int instanced;
+static GLuint instance_program;
+static GLuint instance_vbo;
+static GLuint corner_vbo;
+static GLint viewport_uniform;
+static GLint atlas_size_uniform;
+static Instance instance_buf[BUFFER_SIZE];
+
+// The distance field shares the atlas' normalized rects, so glyph instances keep their src
+static int sdf_text;
+static int sdf_text_tried;
+static GLuint glyph_texture;
+
+// Offscreen layers: draws are redirected into the bound layer with its origin at (0, 0)
+typedef struct {
+    GLuint framebuffer;
+    GLuint texture;
+    int width;
+    int height;
+} Layer;
+
+static Layer layers[R_MAX_LAYERS];
+static int origin_x;
+static int origin_y;
+static int screen_width;
+static int screen_height;
+static GLuint atlas_texture;
 
 extern SDL_Window *window;
 
-int r_init(void) {
+static void load_atlas(const char *path) {
+    if (path != NULL) {
+        if (atlas_load(&atlas, path) == 0) { return; }
+        fprintf(stderr, "Falling back to the embedded atlas\n");
+    } else {
+        char *base = SDL_GetBasePath();
+        if (base != NULL) {
+            char default_path[1024];
+            snprintf(default_path, sizeof(default_path), "%s%s", base, ATLAS_FILE_NAME);
+            SDL_free(base);
+            if (atlas_load(&atlas, default_path) == 0) { return; }
+        }
+    }
+    atlas_load_embedded(&atlas);
+}
+
+int r_init(const char *atlas_path) {
     // Create OpenGL context first
-    const SDL_GLContext context = SDL_GL_CreateContext(window);
+    context = SDL_GL_CreateContext(window);
     if (context == NULL) {
         fprintf(stderr, "Failed to create OpenGL context: %s\n", SDL_GetError());
         return -1;
     }
+    profiler_startup_mark("GL context");
 
     // Set OpenGL attributes before creating context
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
@@ -43,14 +171,25 @@ int r_init(void) {
     glEnableClientState(GL_COLOR_ARRAY);
 
     /* init texture */
+    load_atlas(atlas_path);
+    gl_api_load();
     GLuint id;
     glGenTextures(1, &id);
     glBindTexture(GL_TEXTURE_2D, id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_WIDTH, ATLAS_HEIGHT, 0,
-                 GL_ALPHA, GL_UNSIGNED_BYTE, atlas_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, atlas.width, atlas.height, 0,
+                 GL_ALPHA, GL_UNSIGNED_BYTE, atlas.pixels);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
+    // The pixels live in GL now. Shader contexts keep them so r_enable_sdf_text can build
+    // the distance field from them; it's only paid for when asked for.
+    if (!gl_api.has_instancing) {
+        atlas_release_pixels(&atlas);
+    }
+    atlas_texture = id;
+    profiler_startup_mark("atlas upload");
+
     // Check for errors after initialization
     const GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
@@ -59,23 +198,158 @@ int r_init(void) {
     return 0;
 }
 
-void r_update_dimensions(const int w, const int h) {
-#ifdef __APPLE__
-        // Get the actual pixel dimensions for Retina displays
-        int drawable_width, drawable_height;
-        SDL_GL_GetDrawableSize(window, &drawable_width, &drawable_height);
-        width = drawable_width;
-        height = drawable_height;
-        glViewport(0, 0, drawable_width, drawable_height);
-#else
-    width = w;
-    height = h;
+int r_enable_instancing(void) {
+    if (!gl_api.has_instancing) {
+        fprintf(stderr, "Instanced rendering unavailable (needs GLSL and instanced arrays)\n");
+        return -1;
+    }
+
+    instance_program = gl_api_create_program(instance_vertex_shader, instance_fragment_shader,
+                                             instance_attribs, sizeof(instance_attribs) / sizeof(instance_attribs[0]));
+    if (instance_program == 0) { return -1; }
+
+    static const GLfloat corners[] = {0, 0, 1, 0, 0, 1, 1, 1};
+    gl_api.GenBuffers(1, &corner_vbo);
+    gl_api.BindBuffer(GL_ARRAY_BUFFER, corner_vbo);
+    gl_api.BufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    gl_api.GenBuffers(1, &instance_vbo);
+    gl_api.BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    gl_api.UseProgram(instance_program);
+    gl_api.Uniform1i(gl_api.GetUniformLocation(instance_program, "atlas"), 0);
+    gl_api.Uniform1i(gl_api.GetUniformLocation(instance_program, "glyphs"), 1);
+    viewport_uniform = gl_api.GetUniformLocation(instance_program, "viewport");
+    atlas_size_uniform = gl_api.GetUniformLocation(instance_program, "atlas_size");
+    gl_api.UseProgram(0);
+
+    // The legacy client arrays would alias generic attribute 0 in compatibility contexts
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+
+    instanced = 1;
+    return 0;
+}
+
+int r_enable_sdf_text(void) {
+    if (!instanced || atlas.pixels == NULL) {
+        fprintf(stderr, "SDF text unavailable (needs the instanced renderer)\n");
+        return -1;
+    }
+
+    unsigned char *field = atlas_build_glyph_sdf(&atlas);
+    if (field == NULL) {
+        fprintf(stderr, "Failed to build the glyph distance field\n");
+        return -1;
+    }
+    atlas_release_pixels(&atlas);
+
+    glGenTextures(1, &glyph_texture);
+    gl_api.ActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, glyph_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, atlas.width * ATLAS_SDF_UPSCALE, atlas.height * ATLAS_SDF_UPSCALE, 0,
+                 GL_ALPHA, GL_UNSIGNED_BYTE, field);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl_api.ActiveTexture(GL_TEXTURE0);
+    free(field);
+
+    sdf_text = 1;
+    return 0;
+}
+
+int r_make_current(void) {
+    if (SDL_GL_MakeCurrent(window, context) != 0) {
+        fprintf(stderr, "Failed to make the OpenGL context current: %s\n", SDL_GetError());
+        return -1;
+    }
+    return 0;
+}
+
+void r_release_current(void) {
+    SDL_GL_MakeCurrent(window, NULL);
+}
+
+void r_begin_frame(const int w, const int h, const int s) {
+    // w/h are drawable (pixel) dimensions on every platform. The draw scale travels with
+    // the frame so a render thread never reads the metrics scale the UI thread is changing.
+    width = screen_width = w;
+    height = screen_height = h;
+    draw_scale = mu_clamp(s, 1, MAX_UI_SCALE);
     glViewport(0, 0, w, h);
-#endif
+
+    // There is only the 1x atlas, so scaled text switches to the distance field once instead
+    // of magnifying glyphs; this runs on the thread that owns the context
+    if (draw_scale != 1 && instanced && !sdf_text && !sdf_text_tried) {
+        sdf_text_tried = 1;
+        if (r_enable_sdf_text() != 0) { fprintf(stderr, "Scaled text stays magnified bitmap glyphs\n"); }
+    }
+}
+
+void r_set_scale(const int s) {
+    // Only the glyph metrics follow the scale; r_begin_frame moves scaled text to the
+    // distance field when the instanced renderer is on
+    scale = mu_clamp(s, 1, MAX_UI_SCALE);
+}
+
+int r_get_scale(void) {
+    return scale;
+}
+
+static void flush_instances(void) {
+    gl_api.UseProgram(instance_program);
+    gl_api.Uniform2f(viewport_uniform, (GLfloat) width, (GLfloat) height);
+    gl_api.Uniform2f(atlas_size_uniform, (GLfloat) atlas.width, (GLfloat) atlas.height);
+
+    gl_api.BindBuffer(GL_ARRAY_BUFFER, corner_vbo);
+    gl_api.EnableVertexAttribArray(ATTRIB_CORNER);
+    gl_api.VertexAttribPointer(ATTRIB_CORNER, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+
+    // Respecifying the whole store orphans the previous one, so the driver never waits on it
+    gl_api.BindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    gl_api.BufferData(GL_ARRAY_BUFFER, buf_idx * sizeof(Instance), instance_buf, GL_STREAM_DRAW);
+
+    static const struct {
+        GLuint index;
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        size_t offset;
+    } layout[] = {
+        {ATTRIB_DST, 4, GL_SHORT, GL_FALSE, offsetof(Instance, dst)},
+        {ATTRIB_SRC, 4, GL_SHORT, GL_FALSE, offsetof(Instance, src)},
+        {ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Instance, color)},
+        {ATTRIB_BORDER, 1, GL_SHORT, GL_FALSE, offsetof(Instance, border_width)},
+        {ATTRIB_GLYPH, 1, GL_SHORT, GL_FALSE, offsetof(Instance, glyph)},
+    };
+    for (size_t i = 0; i < sizeof(layout) / sizeof(layout[0]); i++) {
+        gl_api.EnableVertexAttribArray(layout[i].index);
+        gl_api.VertexAttribPointer(layout[i].index, layout[i].size, layout[i].type, layout[i].normalized,
+                                   sizeof(Instance), (const void *) layout[i].offset);
+        gl_api.VertexAttribDivisor(layout[i].index, 1);
+    }
+
+    gl_api.DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, buf_idx);
+
+    for (size_t i = 0; i < sizeof(layout) / sizeof(layout[0]); i++) {
+        gl_api.VertexAttribDivisor(layout[i].index, 0);
+        gl_api.DisableVertexAttribArray(layout[i].index);
+    }
+    gl_api.DisableVertexAttribArray(ATTRIB_CORNER);
+    gl_api.BindBuffer(GL_ARRAY_BUFFER, 0);
+    gl_api.UseProgram(0);
+
+    buf_idx = 0;
 }
 
 static void flush(void) {
     if (buf_idx == 0) { return; }
+    if (instanced) {
+        flush_instances();
+        return;
+    }
 
     glViewport(0, 0, width, height);
     glMatrixMode(GL_PROJECTION);
@@ -99,7 +373,35 @@ static void flush(void) {
     buf_idx = 0;
 }
 
-static void push_quad(const mu_Rect dst, const mu_Rect src, const mu_Color color) {
+static void push_instance(const mu_Rect dst, const mu_Rect src, const mu_Color color, const int border_width,
+                          const int glyph) {
+    if (buf_idx >= BUFFER_SIZE) { flush(); }
+
+    Instance *instance = &instance_buf[buf_idx++];
+    instance->dst[0] = dst.x;
+    instance->dst[1] = dst.y;
+    instance->dst[2] = dst.w;
+    instance->dst[3] = dst.h;
+    instance->src[0] = src.x;
+    instance->src[1] = src.y;
+    instance->src[2] = src.w;
+    instance->src[3] = src.h;
+    memcpy(instance->color, &color, 4);
+    instance->border_width = border_width;
+    instance->glyph = glyph;
+}
+
+static mu_Rect to_target(const mu_Rect rect) {
+    return mu_rect(rect.x - origin_x, rect.y - origin_y, rect.w, rect.h);
+}
+
+static void push_quad(mu_Rect dst, const mu_Rect src, const mu_Color color) {
+    dst = to_target(dst);
+    if (instanced) {
+        push_instance(dst, src, color, 0, 0);
+        return;
+    }
+
     if (buf_idx >= BUFFER_SIZE) {
         flush();
         if (buf_idx >= BUFFER_SIZE) {
@@ -115,10 +417,10 @@ static void push_quad(const mu_Rect dst, const mu_Rect src, const mu_Color color
     buf_idx++;
 
     /* update texture buffer */
-    const float x = src.x / (float) ATLAS_WIDTH;
-    const float y = src.y / (float) ATLAS_HEIGHT;
-    const float w = src.w / (float) ATLAS_WIDTH;
-    const float h = src.h / (float) ATLAS_HEIGHT;
+    const float x = src.x / (float) atlas.width;
+    const float y = src.y / (float) atlas.height;
+    const float w = src.w / (float) atlas.width;
+    const float h = src.h / (float) atlas.height;
     tex_buf[texvert_idx + 0] = x;
     tex_buf[texvert_idx + 1] = y;
     tex_buf[texvert_idx + 2] = x + w;
@@ -154,46 +456,233 @@ static void push_quad(const mu_Rect dst, const mu_Rect src, const mu_Color color
 }
 
 void r_draw_rect(const mu_Rect rect, const mu_Color color) {
-    push_quad(rect, atlas[ATLAS_WHITE], color);
+    push_quad(rect, atlas.rects[ATLAS_WHITE], color);
 }
 
-void r_draw_text(const char *text, const mu_Vec2 pos, const mu_Color color) {
-    mu_Rect dst = {pos.x, pos.y, 0, 0};
-    for (const char *p = text; *p; p++) {
-        if ((*p & 0xc0) == 0x80) { continue; }
-        const int chr = mu_min((unsigned char) *p, 127);
-        const mu_Rect src = atlas[ATLAS_FONT + chr];
-        dst.w = src.w;
-        dst.h = src.h;
-        push_quad(dst, src, color);
-        dst.x += dst.w;
+void r_draw_box(const mu_Rect rect, const mu_Color color) {
+    if (instanced) {
+        push_instance(to_target(rect), atlas.rects[ATLAS_WHITE], color, BOX_BORDER_WIDTH, 0);
+        return;
     }
+
+    // Same four edges mu_draw_box emits
+    const mu_Rect white = atlas.rects[ATLAS_WHITE];
+    push_quad(mu_rect(rect.x + 1, rect.y, rect.w - 2, 1), white, color);
+    push_quad(mu_rect(rect.x + 1, rect.y + rect.h - 1, rect.w - 2, 1), white, color);
+    push_quad(mu_rect(rect.x, rect.y, 1, rect.h), white, color);
+    push_quad(mu_rect(rect.x + rect.w - 1, rect.y, 1, rect.h), white, color);
 }
 
-void r_draw_icon(const int id, const mu_Rect rect, const mu_Color color) {
-    const mu_Rect src = atlas[id];
-    const int x = rect.x + (rect.w - src.w) / 2;
-    const int y = rect.y + (rect.h - src.h) / 2;
-    push_quad(mu_rect(x, y, src.w, src.h), src, color);
+void r_draw_polyline(const mu_Rect rect, const short *spans, const int columns, const mu_Color color,
+                     const mu_Color fill) {
+    const mu_Rect white = atlas.rects[ATLAS_WHITE];
+    for (int i = 0; i < columns; i++) {
+        const int top = spans[2 * i], bottom = spans[2 * i + 1];
+        if (top > bottom) { continue; }
+        push_quad(mu_rect(rect.x + i, rect.y + top, 1, bottom - top + 1), white, color);
+        if (fill.a > 0 && bottom + 1 < rect.h) {
+            push_quad(mu_rect(rect.x + i, rect.y + bottom + 1, 1, rect.h - bottom - 1), white, fill);
+        }
+    }
+}
+
+static int font_percent(const mu_Font font) {
+    const intptr_t percent = (intptr_t) font;
+    return percent > 0 && percent <= R_MAX_FONT_PERCENT ? (int) percent : FONT_BODY_PERCENT;
+}
+
+// Atlas pixels to frame pixels at a text scale and font size, rounded to nearest
+static int font_pixels(const int atlas_pixels, const int text_scale, const int percent) {
+    return (atlas_pixels * text_scale * percent + FONT_BODY_PERCENT / 2) / FONT_BODY_PERCENT;
 }
 
-int r_get_text_width(const char *text, int len) {
+static int atlas_text_width(const char *text, int len) {
     int res = 0;
     for (const char *p = text; *p && len--; p++) {
         if ((*p & 0xc0) == 0x80) { continue; }
         const int chr = mu_min((unsigned char) *p, 127);
-        res += atlas[ATLAS_FONT + chr].w;
+        res += atlas.rects[ATLAS_FONT + chr].w;
     }
     return res;
 }
 
-int r_get_text_height(void) {
-    return 18;
+static void push_glyph(const mu_Rect dst, const mu_Rect src, const mu_Color color) {
+    if (sdf_text) {
+        push_instance(to_target(dst), src, color, 0, 1);
+        return;
+    }
+    push_quad(dst, src, color);
+}
+
+void r_draw_text(const mu_Font font, const char *text, const mu_Vec2 pos, const mu_Color color) {
+    // Glyph edges are placed from the running advance so rounding never accumulates and
+    // the text spans exactly what r_get_text_width reported
+    const int percent = font_percent(font);
+    int advance = 0;
+    mu_Rect dst = {pos.x, pos.y, 0, 0};
+    for (const char *p = text; *p; p++) {
+        if ((*p & 0xc0) == 0x80) { continue; }
+        const int chr = mu_min((unsigned char) *p, 127);
+        const mu_Rect src = atlas.rects[ATLAS_FONT + chr];
+        dst.x = pos.x + font_pixels(advance, draw_scale, percent);
+        advance += src.w;
+        dst.w = pos.x + font_pixels(advance, draw_scale, percent) - dst.x;
+        dst.h = font_pixels(src.h, draw_scale, percent);
+        push_glyph(dst, src, color);
+    }
+}
+
+void r_draw_icon(const int id, const mu_Rect rect, const mu_Color color) {
+    if (id < 0 || id >= atlas.rect_count) { return; }
+    const mu_Rect src = atlas.rects[id];
+    const int w = src.w * draw_scale;
+    const int h = src.h * draw_scale;
+    const int x = rect.x + (rect.w - w) / 2;
+    const int y = rect.y + (rect.h - h) / 2;
+    push_quad(mu_rect(x, y, w, h), src, color);
+}
+
+int r_get_text_width(const mu_Font font, const char *text, const int len) {
+    return font_pixels(atlas_text_width(text, len), scale, font_percent(font));
+}
+
+int r_get_text_height(const mu_Font font) {
+    return font_pixels(atlas.line_height, scale, font_percent(font));
 }
 
 void r_set_clip_rect(const mu_Rect rect) {
     flush();
-    glScissor(rect.x, height - (rect.y + rect.h), rect.w, rect.h);
+    if (rect.w >= R_UNCLIPPED_SIZE) {
+        glScissor(0, 0, width, height);
+        return;
+    }
+    const mu_Rect r = to_target(rect);
+    glScissor(r.x, height - (r.y + r.h), r.w, r.h);
+}
+
+int r_layers_supported(void) {
+    return gl_api.has_framebuffers;
+}
+
+int r_layer_create(const int w, const int h) {
+    if (!gl_api.has_framebuffers || w <= 0 || h <= 0 || w > R_MAX_LAYER_SIZE || h > R_MAX_LAYER_SIZE) { return -1; }
+
+    int id = 0;
+    while (id < R_MAX_LAYERS && layers[id].framebuffer != 0) { id++; }
+    if (id == R_MAX_LAYERS) { return -1; }
+
+    Layer *layer = &layers[id];
+    glGenTextures(1, &layer->texture);
+    glBindTexture(GL_TEXTURE_2D, layer->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, atlas_texture);
+
+    gl_api.GenFramebuffers(1, &layer->framebuffer);
+    gl_api.BindFramebuffer(GL_FRAMEBUFFER, layer->framebuffer);
+    gl_api.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layer->texture, 0);
+    const GLenum status = gl_api.CheckFramebufferStatus(GL_FRAMEBUFFER);
+    gl_api.BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    layer->width = w;
+    layer->height = h;
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Layer framebuffer incomplete: 0x%x\n", status);
+        r_layer_destroy(id);
+        return -1;
+    }
+    return id;
+}
+
+void r_layer_destroy(const int id) {
+    Layer *layer = &layers[id];
+    gl_api.DeleteFramebuffers(1, &layer->framebuffer);
+    glDeleteTextures(1, &layer->texture);
+    memset(layer, 0, sizeof(*layer));
+}
+
+void r_layer_begin(const int id, const int x, const int y) {
+    flush();
+    const Layer *layer = &layers[id];
+    origin_x = x;
+    origin_y = y;
+    width = layer->width;
+    height = layer->height;
+
+    gl_api.BindFramebuffer(GL_FRAMEBUFFER, layer->framebuffer);
+    glViewport(0, 0, width, height);
+    glScissor(0, 0, width, height);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Accumulate premultiplied colour with real coverage in alpha so the layer composites
+    // over anything exactly like drawing the commands there directly would
+    gl_api.BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void r_layer_end(void) {
+    flush();
+    origin_x = origin_y = 0;
+    width = screen_width;
+    height = screen_height;
+
+    gl_api.BindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glViewport(0, 0, width, height);
+    glScissor(0, 0, width, height);
+}
+
+void r_layer_draw(const int id, const int x, const int y, const float opacity) {
+    flush();
+    const Layer *layer = &layers[id];
+    const GLfloat w = (GLfloat) layer->width, h = (GLfloat) layer->height;
+    // Texture rows run bottom-up, so the top edge samples t = 1
+    const GLfloat verts[] = {x, y, x + w, y, x, y + h, x + w, y + h};
+    const GLfloat texcoords[] = {0, 1, 1, 1, 0, 0, 1, 0};
+
+    glScissor(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0.0f, width, height, 0.0f, -1.0f, +1.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    // The instanced path leaves the client arrays disabled; the legacy one keeps colours on
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glBindTexture(GL_TEXTURE_2D, layer->texture);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(opacity, opacity, opacity, opacity);
+    glVertexPointer(2, GL_FLOAT, 0, verts);
+    glTexCoordPointer(2, GL_FLOAT, 0, texcoords);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glColor4f(1, 1, 1, 1);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindTexture(GL_TEXTURE_2D, atlas_texture);
+    if (instanced) {
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    } else {
+        glEnableClientState(GL_COLOR_ARRAY);
+    }
+
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+}
+
+int r_measure_text(const mu_Font font, const char *text, const int text_scale) {
+    return font_pixels(atlas_text_width(text, -1), text_scale, font_percent(font));
+}
+
+int r_get_line_height(const mu_Font font, const int text_scale) {
+    return font_pixels(atlas.line_height, text_scale, font_percent(font));
 }
 
 void r_clear(const mu_Color color) {
@@ -205,4 +694,5 @@ void r_clear(const mu_Color color) {
 void r_present(void) {
     flush();
     SDL_GL_SwapWindow(window);
+    profiler_startup_finish("first present");
 }
@@ -1,24 +1,82 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <stdint.h>
 #include "microui.h"
 
-int r_init(void);
+#define R_MAX_LAYERS 16
+#define R_MAX_LAYER_SIZE 4096
 
-void r_update_dimensions(int w, int h);
+// Size of MicroUI's unclipped_rect, which it sets when nothing is clipped. r_set_clip_rect
+// takes a clip this large to mean no clip, so it holds for content left of or above 0 too.
+#define R_UNCLIPPED_SIZE 0x1000000
+
+// Text sizes travel in MicroUI's font handle as a percentage of the atlas glyphs, so frames
+// mean the same thing in every process; NULL is the body size. Sizes that aren't a whole
+// multiple of the atlas only look smooth with SDF text.
+#define R_FONT_SIZE(percent) ((mu_Font) (intptr_t) (percent))
+#define R_MAX_FONT_PERCENT 800
+
+int r_init(const char *atlas_path);
+
+// Switches to the shader path that draws each primitive as one instance; returns -1 and
+// keeps the fixed-function path if the context can't do it
+int r_enable_instancing(void);
+
+// Draws glyphs from a distance field built from the atlas, so text stays sharp at every
+// size and scale. Needs the instanced renderer, which turns it on by itself at scales above 1.
+int r_enable_sdf_text(void);
+
+// Moves the GL context between threads; only the thread that made it current may draw
+int r_make_current(void);
+
+void r_release_current(void);
+
+void r_begin_frame(int w, int h, int scale);
+
+void r_set_scale(int scale);
+
+int r_get_scale(void);
 
 void r_draw_rect(mu_Rect rect, mu_Color color);
 
-void r_draw_text(const char *text, mu_Vec2 pos, mu_Color color);
+// One-pixel outline, as drawn by mu_draw_box
+void r_draw_box(mu_Rect rect, mu_Color color);
+
+// Column spans as laid out in a PolylineCommand, drawn as one quad per column (two with a
+// fill) into the current batch
+void r_draw_polyline(mu_Rect rect, const short *spans, int columns, mu_Color color, mu_Color fill);
+
+void r_draw_text(mu_Font font, const char *text, mu_Vec2 pos, mu_Color color);
 
 void r_draw_icon(int id, mu_Rect rect, mu_Color color);
 
-int r_get_text_width(const char *text, int len);
+int r_get_text_width(mu_Font font, const char *text, int len);
 
-int r_get_text_height(void);
+int r_get_text_height(mu_Font font);
 
 void r_set_clip_rect(mu_Rect rect);
 
+// Text extent at an explicit scale, for code running with a frame's draw scale
+int r_measure_text(mu_Font font, const char *text, int text_scale);
+
+int r_get_line_height(mu_Font font, int text_scale);
+
+// Offscreen layers. Between r_layer_begin and r_layer_end every draw lands in the layer,
+// with (x, y) in frame coordinates mapping to its top-left corner. r_layer_draw composites
+// the layer at (x, y); layers hold premultiplied colour.
+int r_layers_supported(void);
+
+int r_layer_create(int w, int h);
+
+void r_layer_destroy(int id);
+
+void r_layer_begin(int id, int x, int y);
+
+void r_layer_end(void);
+
+void r_layer_draw(int id, int x, int y, float opacity);
+
 void r_clear(mu_Color color);
 
 void r_present(void);
@@ -0,0 +1,326 @@
+#include "src/Config/Trace.h"
+#include "src/Systems/AllocTracker.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * File layout (all integers little-endian):
+ *   char     magic[4]      "SFTR"
+ *   uint16   version
+ *   uint8    pointer_size  command structs hold pointer-sized fields, so traces are ABI specific
+ *   uint8    reserved
+ * followed by one record per frame:
+ *   uint16   event_count
+ *   uint16   flags         TRACE_FRAME_*
+ *   uint32   delta_us      time since the previous frame was recorded
+ *   uint16   width, height
+ *   uint16   scale
+ *   uint8    clear[4]      r, g, b, a
+ *   uint32   command_bytes 0 when TRACE_FRAME_REPEAT is set
+ *   events   uint32 SDL event type + type specific int32 fields (TEXTINPUT: 32 bytes)
+ *   uint8    commands[command_bytes]  flattened CommandBuffer contents
+ */
+#define TRACE_HEADER_SIZE 8
+#define TRACE_FRAME_HEADER_SIZE 22
+#define TRACE_MAX_EVENT_FIELDS 3
+#define TRACE_WRITE_BUFFER_SIZE (1 << 20)
+
+enum {
+    // Commands are identical to the previous frame's and were not stored again
+    TRACE_FRAME_REPEAT = (1 << 0)
+};
+
+typedef struct {
+    FILE *file;
+    uint64_t last_counter;
+    SDL_Event events[TRACE_MAX_EVENTS];
+    int event_count;
+    int dropped_events;
+    int frames;
+    int repeats;
+    CommandBuffer previous;
+} Recorder;
+
+static Recorder *recorder;
+
+static void write_u16(unsigned char *p, const unsigned v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void write_u32(unsigned char *p, const uint32_t v) {
+    write_u16(p, v & 0xffff);
+    write_u16(p + 2, v >> 16);
+}
+
+static unsigned read_u16(const unsigned char *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t read_u32(const unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+// Returns the number of int32 fields stored for an event type, or -1 if it isn't recorded
+static int event_fields(const SDL_Event *e, int32_t fields[TRACE_MAX_EVENT_FIELDS]) {
+    switch (e->type) {
+        case SDL_QUIT:
+            return 0;
+        case SDL_MOUSEMOTION:
+            fields[0] = e->motion.x;
+            fields[1] = e->motion.y;
+            return 2;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            fields[0] = e->button.button;
+            fields[1] = e->button.x;
+            fields[2] = e->button.y;
+            return 3;
+        case SDL_MOUSEWHEEL:
+            fields[0] = e->wheel.x;
+            fields[1] = e->wheel.y;
+            return 2;
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            fields[0] = e->key.keysym.sym;
+            return 1;
+        case SDL_WINDOWEVENT:
+            fields[0] = e->window.event;
+            fields[1] = e->window.data1;
+            fields[2] = e->window.data2;
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+static void decode_event(SDL_Event *e, const uint32_t type, const int32_t *fields) {
+    memset(e, 0, sizeof(*e));
+    e->type = type;
+    switch (type) {
+        case SDL_MOUSEMOTION:
+            e->motion.x = fields[0];
+            e->motion.y = fields[1];
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            e->button.button = fields[0];
+            e->button.x = fields[1];
+            e->button.y = fields[2];
+            break;
+        case SDL_MOUSEWHEEL:
+            e->wheel.x = fields[0];
+            e->wheel.y = fields[1];
+            break;
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            e->key.keysym.sym = fields[0];
+            break;
+        case SDL_WINDOWEVENT:
+            e->window.event = fields[0];
+            e->window.data1 = fields[1];
+            e->window.data2 = fields[2];
+            break;
+        default:
+            break;
+    }
+}
+
+int trace_record_start(const char *path) {
+    recorder = tracked_calloc(ALLOC_TRACE, 1, sizeof(Recorder));
+    if (recorder == NULL) { return -1; }
+
+    recorder->file = fopen(path, "wb");
+    if (recorder->file == NULL) {
+        fprintf(stderr, "Failed to open trace file %s\n", path);
+        tracked_free(recorder);
+        recorder = NULL;
+        return -1;
+    }
+    setvbuf(recorder->file, NULL, _IOFBF, TRACE_WRITE_BUFFER_SIZE);
+
+    unsigned char header[TRACE_HEADER_SIZE] = {0};
+    memcpy(header, TRACE_FILE_MAGIC, 4);
+    write_u16(header + 4, TRACE_FILE_VERSION);
+    header[6] = sizeof(void *);
+    fwrite(header, sizeof(header), 1, recorder->file);
+
+    recorder->previous.size = -1;
+    recorder->last_counter = SDL_GetPerformanceCounter();
+    return 0;
+}
+
+int trace_is_recording(void) {
+    return recorder != NULL;
+}
+
+void trace_record_event(const SDL_Event *e) {
+    if (recorder == NULL) { return; }
+
+    int32_t fields[TRACE_MAX_EVENT_FIELDS];
+    if (e->type != SDL_TEXTINPUT && event_fields(e, fields) < 0) { return; }
+
+    if (recorder->event_count >= TRACE_MAX_EVENTS) {
+        recorder->dropped_events++;
+        return;
+    }
+    recorder->events[recorder->event_count++] = *e;
+}
+
+void trace_record_frame(const CommandBuffer *buf) {
+    if (recorder == NULL) { return; }
+
+    const uint64_t now = SDL_GetPerformanceCounter();
+    const uint64_t delta_us = (now - recorder->last_counter) * 1000000 / SDL_GetPerformanceFrequency();
+    recorder->last_counter = now;
+
+    // Idle frames are common, so unchanged command lists are stored as a flag only
+    const int repeat = buf->size == recorder->previous.size &&
+                       memcmp(buf->commands, recorder->previous.commands, buf->size) == 0;
+
+    unsigned char header[TRACE_FRAME_HEADER_SIZE];
+    write_u16(header, recorder->event_count);
+    write_u16(header + 2, repeat ? TRACE_FRAME_REPEAT : 0);
+    write_u32(header + 4, delta_us > UINT32_MAX ? UINT32_MAX : (uint32_t) delta_us);
+    write_u16(header + 8, buf->width);
+    write_u16(header + 10, buf->height);
+    write_u16(header + 12, buf->scale);
+    header[14] = buf->clear.r;
+    header[15] = buf->clear.g;
+    header[16] = buf->clear.b;
+    header[17] = buf->clear.a;
+    write_u32(header + 18, repeat ? 0 : buf->size);
+    fwrite(header, sizeof(header), 1, recorder->file);
+
+    for (int i = 0; i < recorder->event_count; i++) {
+        const SDL_Event *e = &recorder->events[i];
+        unsigned char record[4 + sizeof(e->text.text)];
+        write_u32(record, e->type);
+
+        size_t length = 4;
+        if (e->type == SDL_TEXTINPUT) {
+            memcpy(record + 4, e->text.text, sizeof(e->text.text));
+            length += sizeof(e->text.text);
+        } else {
+            int32_t fields[TRACE_MAX_EVENT_FIELDS];
+            const int count = event_fields(e, fields);
+            for (int f = 0; f < count; f++) {
+                write_u32(record + length, (uint32_t) fields[f]);
+                length += 4;
+            }
+        }
+        fwrite(record, length, 1, recorder->file);
+    }
+    recorder->event_count = 0;
+
+    if (repeat) {
+        recorder->repeats++;
+    } else {
+        fwrite(buf->commands, 1, buf->size, recorder->file);
+        memcpy(recorder->previous.commands, buf->commands, buf->size);
+        recorder->previous.size = buf->size;
+    }
+    recorder->frames++;
+}
+
+void trace_record_stop(void) {
+    if (recorder == NULL) { return; }
+
+    if (fclose(recorder->file) != 0) {
+        fprintf(stderr, "Failed to write trace file\n");
+    }
+    printf("Recorded %d frames (%d repeated, %d events dropped)\n",
+           recorder->frames, recorder->repeats, recorder->dropped_events);
+    tracked_free(recorder);
+    recorder = NULL;
+}
+
+int trace_reader_open(TraceReader *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->file = fopen(path, "rb");
+    if (reader->file == NULL) {
+        fprintf(stderr, "Failed to open trace file %s\n", path);
+        return -1;
+    }
+
+    unsigned char header[TRACE_HEADER_SIZE];
+    if (fread(header, sizeof(header), 1, reader->file) != 1 ||
+        memcmp(header, TRACE_FILE_MAGIC, 4) != 0 || read_u16(header + 4) != TRACE_FILE_VERSION) {
+        fprintf(stderr, "Invalid trace file: %s\n", path);
+        trace_reader_close(reader);
+        return -1;
+    }
+    if (header[6] != sizeof(void *)) {
+        fprintf(stderr, "Trace %s was recorded with %d-bit pointers\n", path, header[6] * 8);
+        trace_reader_close(reader);
+        return -1;
+    }
+    return 0;
+}
+
+int trace_reader_next(TraceReader *reader, CommandBuffer *buf) {
+    unsigned char header[TRACE_FRAME_HEADER_SIZE];
+    const size_t got = fread(header, 1, sizeof(header), reader->file);
+    if (got == 0 && feof(reader->file)) { return 0; }
+    if (got != sizeof(header)) { return -1; }
+
+    const unsigned flags = read_u16(header + 2);
+    const uint32_t command_bytes = read_u32(header + 18);
+    reader->event_count = read_u16(header);
+    reader->timestamp_us += read_u32(header + 4);
+    if (reader->event_count > TRACE_MAX_EVENTS || command_bytes > sizeof(buf->commands)) { return -1; }
+
+    buf->width = read_u16(header + 8);
+    buf->height = read_u16(header + 10);
+    buf->scale = read_u16(header + 12);
+    buf->clear = mu_color(header[14], header[15], header[16], header[17]);
+
+    for (int i = 0; i < reader->event_count; i++) {
+        unsigned char type_bytes[4];
+        if (fread(type_bytes, sizeof(type_bytes), 1, reader->file) != 1) { return -1; }
+        const uint32_t type = read_u32(type_bytes);
+        SDL_Event *e = &reader->events[i];
+
+        if (type == SDL_TEXTINPUT) {
+            memset(e, 0, sizeof(*e));
+            e->type = type;
+            if (fread(e->text.text, sizeof(e->text.text), 1, reader->file) != 1) { return -1; }
+            e->text.text[sizeof(e->text.text) - 1] = '\0';
+            continue;
+        }
+
+        SDL_Event probe = {.type = type};
+        int32_t fields[TRACE_MAX_EVENT_FIELDS];
+        const int count = event_fields(&probe, fields);
+        if (count < 0) { return -1; }
+        unsigned char payload[TRACE_MAX_EVENT_FIELDS * 4];
+        if (count > 0 && fread(payload, 4, count, reader->file) != (size_t) count) { return -1; }
+        for (int f = 0; f < count; f++) {
+            fields[f] = (int32_t) read_u32(payload + f * 4);
+        }
+        decode_event(e, type, fields);
+    }
+
+    if (!(flags & TRACE_FRAME_REPEAT)) {
+        if (fread(buf->commands, 1, command_bytes, reader->file) != command_bytes) { return -1; }
+        buf->size = command_bytes;
+
+        // Root container boundaries aren't recorded; the frame replays as one segment
+        buf->segment_count = buf->size > 0;
+        buf->segments[0] = 0;
+
+        // A corrupt command would make command_buffer_render read past it or the buffer
+        if (!command_buffer_valid(buf)) { return -1; }
+    } else if (reader->frame == 0) {
+        return -1;
+    }
+    reader->frame++;
+    return 1;
+}
+
+void trace_reader_close(TraceReader *reader) {
+    if (reader->file != NULL) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
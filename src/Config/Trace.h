@@ -0,0 +1,40 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "src/Config/CommandBuffer.h"
+
+#define TRACE_FILE_MAGIC "SFTR"
+#define TRACE_FILE_VERSION 2
+#define TRACE_MAX_EVENTS 256
+
+// Recording: events are collected as they are handled and written out with the next frame
+int trace_record_start(const char *path);
+
+void trace_record_event(const SDL_Event *e);
+
+void trace_record_frame(const CommandBuffer *buf);
+
+void trace_record_stop(void);
+
+int trace_is_recording(void);
+
+typedef struct {
+    FILE *file;
+    int frame;
+    uint64_t timestamp_us;
+    SDL_Event events[TRACE_MAX_EVENTS];
+    int event_count;
+} TraceReader;
+
+int trace_reader_open(TraceReader *reader, const char *path);
+
+// Reads the next frame into buf; returns 1 on success, 0 at end of trace and -1 on error.
+// buf must hold the previous frame, which repeated frames are not stored again for.
+int trace_reader_next(TraceReader *reader, CommandBuffer *buf);
+
+void trace_reader_close(TraceReader *reader);
+
+#endif
@@ -11,11 +11,19 @@
 #define HEADER_HEIGHT_RATIO 15
 #define MIN_HEADER_HEIGHT 40
 #define CLOSE_BUTTON_PADDING 10
+#define CLOSE_BUTTON_MARGIN 5
 #define MIN_LOG_HEIGHT 100
 #define LOG_HEIGHT_RATIO 4
 #define OPTION_HEIGHT_RATIO 20
 #define MIN_OPTION_HEIGHT 30
 #define SLIDER_LABEL_WIDTH 50
+#define MIN_PLOT_HEIGHT 60
+#define PLOT_HEIGHT_RATIO 8
+
+// Largest UI scale; layout and text both stop growing here. There is only the 1x atlas: the
+// instanced renderer draws scaled text from its distance field, the fixed-function one
+// magnifies it with GL_NEAREST.
+#define MAX_UI_SCALE 4
 
 // Button dimensions
 #define BUTTON_WIDTH_RATIO 6
@@ -34,6 +42,59 @@
 
 // Frame delay
 #define FRAME_DELAY_MS 16
+#define UNFOCUSED_FRAME_DELAY_MS 100
+// How often a hidden window still drains ingest sources and writes log summaries
+#define HIDDEN_DRAIN_INTERVAL_MS 100
+
+// Frames after which nothing inside a frame may allocate
+#define ALLOC_WARMUP_FRAMES 60
+
+// Log file writer
+#define LOG_FLUSH_INTERVAL_MS 200
+#define LOG_SYNC_INTERVAL_MS 1000
+#define LOG_ROTATE_BYTES (8L * 1024 * 1024)
+#define LOG_ROTATE_SECONDS (24 * 60 * 60)
+#define LOG_KEEP_FILES 4
+
+// Logger storms: lines per second each source may log after its burst, and how often
+// repeat counts and suppressed lines are reported
+#define LOG_RATE_PER_SECOND 100
+#define LOG_RATE_BURST 500
+#define LOG_SUMMARY_INTERVAL_MS 1000
+
+// Mapped log viewer: how often growth is checked without inotify, and the address space
+// reserved past the end of the file for appends
+#define MAPPED_LOG_POLL_MS 250
+#define MAPPED_LOG_GROWTH (16ull << 30)
+
+// Log search: how often the worker looks for new lines when idle, and the most memory its
+// trigram index may take before later lines are only scanned
+#define LOG_SEARCH_POLL_MS 100
+#define LOG_SEARCH_MAX_INDEX (512L * 1024 * 1024)
+
+// Most messages from other processes taken off the shared-memory ring per frame
+#define SHM_DRAIN_PER_FRAME 2048
+
+// Socket ingestion: connections served at once, the pool of line batches and the size of
+// each, how often a connection waiting on the pool retries, and the most lines handed to
+// the logger per frame
+#define SOCKET_MAX_CONNECTIONS 256
+#define SOCKET_BATCH_COUNT 256
+#define SOCKET_BATCH_BYTES (16 * 1024)
+#define SOCKET_STALL_RETRY_MS 5
+#define SOCKET_DRAIN_LINES 1024
+
+// Time series: how many there can be and how much each keeps, as raw samples, one-second
+// rollups (an hour) and one-minute rollups (a day)
+#define TIME_SERIES_MAX 32
+#define TIME_SERIES_RAW_SAMPLES 4096
+#define TIME_SERIES_SECOND_BUCKETS 3600
+#define TIME_SERIES_MINUTE_BUCKETS 1440
+
+// Metrics plot: the window it shows, ending at the latest sample, and the most points read
+// for it
+#define METRICS_PLOT_WINDOW_MS 60000
+#define METRICS_PLOT_POINTS 4096
 
 // Other constants
 #define DIVIDE_BY_TWO 2
@@ -44,4 +105,11 @@
 #define HEADER_TEXT_PADDING 10
 #define TITLE_TEXT "SiFe"
 
+// Lets the compiler check printf-style arguments where it can; MSVC has no equivalent
+#ifdef _MSC_VER
+#define PRINTF_FORMAT(fmt_index, first_arg)
+#else
+#define PRINTF_FORMAT(fmt_index, first_arg) __attribute__((format(printf, fmt_index, first_arg)))
+#endif
+
 #endif
@@ -1,142 +1,521 @@
 #include "Menu.h"
 #include "src/Constants.h"
+#include "src/GUI/FrameArena.h"
+#include "src/GUI/UiTree.h"
+#include "src/GUI/Components/Plot.h"
+#include "src/GUI/Components/Widgets.h"
 #include "src/Systems/Logger.h"
-#include <stdio.h>
+#include "src/Systems/LogSearch.h"
+#include "src/Systems/MappedLog.h"
+#include "src/Systems/TimeSeries.h"
+#include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 
-static void draw_menu_content(mu_Context *ctx, UIState *state, const int menu_width, const int header_height) {
-    int option_height = state->window_height / OPTION_HEIGHT_RATIO;
-    if (option_height < MIN_OPTION_HEIGHT) option_height = MIN_OPTION_HEIGHT;
+static UiTree menu_tree;
+
+// Log panel state: whether it sticks to the newest line, a pending jump and the jump box
+static int log_follow = 1;
+static int log_changed;
+static long jump_line = -1;
+static char jump_text[16];
+
+// Levels the in-memory log shows
+static int level_shown[LOG_LEVEL_COUNT] = {1, 1, 1, 1};
+
+// Search box, the match last navigated to and the first line id the panel showed
+static char search_text[LOG_SEARCH_QUERY_MAX];
+static int search_cursor = -1;
+static long log_view_top;
+
+// Metrics plot: whether it is expanded, the series shown, the latest sample seen of it, a
+// version bumped whenever that moves and the points last read, flattened into min/max
+// pairs for the plot
+static int plot_shown;
+static int plot_series;
+static Uint64 plot_latest;
+static unsigned plot_version;
+static unsigned plot_read_version;
+static int plot_value_count;
+static TimeSeriesPoint plot_points[METRICS_PLOT_POINTS];
+static float plot_values[2 * METRICS_PLOT_POINTS];
+static UiPlot metrics_plot;
+
+// Top-left of the menu window, which the header is laid out from while it slides
+static mu_Vec2 menu_origin(mu_Context *ctx) {
+    const mu_Rect rect = mu_get_current_container(ctx)->rect;
+    return mu_vec2(rect.x, rect.y);
+}
+
+static void draw_header_row(mu_Context *ctx, void *user) {
+    const UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 2, (int[]){l->menu_width - l->close_button_size - l->header_text_padding, l->close_button_size},
+                  l->header_height);
+}
+
+static void draw_header_title(mu_Context *ctx, void *user) {
+    const UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_begin_column(ctx); {
+        const int title_width = ctx->text_width(ctx->style->font, TITLE_TEXT, strlen(TITLE_TEXT));
+        const int title_height = ctx->text_height(ctx->style->font);
+        const int text_x = (l->menu_width - l->close_button_size - l->header_text_padding - title_width) / DIVIDE_BY_TWO;
+        const int text_y = (l->header_height - title_height) / DIVIDE_BY_TWO;
+
+        const mu_Vec2 origin = menu_origin(ctx);
+
+        mu_draw_text(ctx, ctx->style->font, TITLE_TEXT, strlen(TITLE_TEXT),
+                     mu_vec2(origin.x + text_x, origin.y + text_y),
+                     mu_color(230, 230, 230, 255));
+    }
+    mu_layout_end_column(ctx);
+}
 
-    // Draw separator
-    mu_layout_row(ctx, 1, (int[]){-1}, SEPARATOR_HEIGHT);
-    mu_draw_rect(ctx, mu_rect(MENU_PADDING_X, header_height + HEADER_SEPARATOR_Y_OFFSET,
-                              menu_width - MENU_CONTENT_WIDTH_OFFSET, SEPARATOR_HEIGHT),
+static void draw_header_close(mu_Context *ctx, void *user) {
+    UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_begin_column(ctx); {
+        const int button_padding = (l->header_height - l->close_button_size) / DIVIDE_BY_TWO;
+        const mu_Vec2 origin = menu_origin(ctx);
+        mu_layout_set_next(ctx, mu_rect(origin.x + l->close_button_x, origin.y + button_padding,
+                                        l->close_button_size, l->close_button_size), 0);
+        if (mu_button_ex(ctx, "X", 0, MU_OPT_ALIGNCENTER)) {
+            state->menu_open = 0;
+            state->dirty |= UI_DIRTY_STATE;
+        }
+    }
+    mu_layout_end_column(ctx);
+}
+
+static void draw_separator(mu_Context *ctx, void *user) {
+    const UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 1, (int[]){-1}, l->separator_height);
+    const mu_Vec2 origin = menu_origin(ctx);
+    mu_draw_rect(ctx, mu_rect(origin.x + l->separator_x, origin.y + l->separator_y, l->separator_width,
+                              l->separator_height),
                  ctx->style->colors[MU_COLOR_BORDER]);
+}
 
-    // Menu options
-    mu_layout_row(ctx, 1, (int[]){-1}, option_height);
+static void draw_options_title(mu_Context *ctx, void *user) {
+    const UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 1, (int[]){-1}, l->option_height);
     mu_text(ctx, "Menu Options");
+}
 
+static void menu_log_option(UIState *state, const int option) {
+    write_logf(LOG_CATEGORY_UI, LOG_LEVEL_INFO, "Selected Option %d", option);
+    state->dirty |= UI_DIRTY_LOG;
+}
+
+static void draw_options(mu_Context *ctx, void *user) {
+    UIState *state = user;
     if (mu_button(ctx, "Option 1")) {
-        write_log("Selected Option 1");
+        menu_log_option(state, 1);
     }
     if (mu_button(ctx, "Option 2")) {
-        write_log("Selected Option 2");
+        menu_log_option(state, 2);
     }
     if (mu_button(ctx, "Option 3")) {
-        write_log("Selected Option 3");
+        menu_log_option(state, 3);
     }
+}
 
-    // Color settings
-    mu_layout_row(ctx, 1, (int[]){-1}, option_height);
+static void draw_color_title(mu_Context *ctx, void *user) {
+    const UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 1, (int[]){-1}, l->option_height);
     mu_label(ctx, "Background Color");
+}
 
-    mu_layout_row(ctx, 2, (int[]){SLIDER_LABEL_WIDTH, -1}, option_height);
+static void draw_color_sliders(mu_Context *ctx, void *user) {
+    UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 2, (int[]){l->slider_label_width, -1}, l->option_height);
 
     mu_label(ctx, "Red:");
-    if (mu_slider(ctx, &state->bg_color[0], 0, 255)) {
+    if (ui_slider(ctx, &state->bg_color[0], 0, 255)) {
+        state->dirty |= UI_DIRTY_STATE;
     }
 
     mu_label(ctx, "Green:");
-    if (mu_slider(ctx, &state->bg_color[1], 0, 255)) {
+    if (ui_slider(ctx, &state->bg_color[1], 0, 255)) {
+        state->dirty |= UI_DIRTY_STATE;
     }
 
     mu_label(ctx, "Blue:");
-    if (mu_slider(ctx, &state->bg_color[2], 0, 255)) {
+    if (ui_slider(ctx, &state->bg_color[2], 0, 255)) {
+        state->dirty |= UI_DIRTY_STATE;
     }
+}
 
-    // Color preview
-    mu_layout_row(ctx, 1, (int[]){-1}, option_height * 1.5);
+static void draw_color_preview(mu_Context *ctx, void *user) {
+    const UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 1, (int[]){-1}, l->option_height * 1.5);
     const mu_Rect r = mu_layout_next(ctx);
     mu_draw_rect(ctx, r, mu_color(state->bg_color[0], state->bg_color[1], state->bg_color[2], 255));
 
-    char color_text[32];
-    snprintf(color_text, sizeof(color_text), "#%02X%02X%02X",
-             (int) state->bg_color[0], (int) state->bg_color[1], (int) state->bg_color[2]);
-    mu_draw_control_text(ctx, color_text, r, MU_COLOR_TEXT, MU_OPT_ALIGNCENTER);
+    const long rgb = ((long) state->bg_color[0] << 16) | ((long) state->bg_color[1] << 8) | (long) state->bg_color[2];
+    mu_draw_control_text(ctx, frame_format_int("#%06lX", rgb), r, MU_COLOR_TEXT, MU_OPT_ALIGNCENTER);
+}
+
+// Collapsed by default so the log panel keeps its place
+static void draw_metrics_title(mu_Context *ctx, void *user) {
+    UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 1, (int[]){-1}, l->option_height);
+    if (mu_checkbox(ctx, "Metrics", &plot_shown)) {
+        plot_version++;
+        state->dirty |= UI_DIRTY_METRICS;
+    }
+}
+
+// Steps through the time series, wrapping at either end
+static void draw_metrics_controls(mu_Context *ctx, void *user) {
+    UIState *state = user;
+    const UILayout *l = &state->layout;
+    if (!plot_shown) { return; }
+    const int count = time_series_count();
+    mu_layout_row(ctx, 3, (int[]){l->option_height, -l->option_height, -1}, l->option_height);
+
+    int step = 0;
+    if (mu_button(ctx, "<")) { step = -1; }
+    mu_label(ctx, count > 0 ? time_series_name(plot_series) : "No metrics yet");
+    if (mu_button(ctx, ">")) { step = 1; }
+
+    if (step != 0 && count > 1) {
+        plot_series = (plot_series + step + count) % count;
+        plot_latest = time_series_latest(plot_series);
+        plot_version++;
+        state->dirty |= UI_DIRTY_METRICS;
+    }
+}
+
+// The last METRICS_PLOT_WINDOW_MS of the series, read at whatever resolution fits the
+// point budget. Each point adds its min and max so rollups keep their spread.
+static void draw_metrics_plot(mu_Context *ctx, void *user) {
+    const UIState *state = user;
+    const UILayout *l = &state->layout;
+    if (!plot_shown) { return; }
+    mu_layout_row(ctx, 1, (int[]){-1}, l->plot_height);
+    if (time_series_count() == 0) {
+        mu_layout_next(ctx);
+        return;
+    }
 
-    // Log section
-    int log_height = state->window_height / LOG_HEIGHT_RATIO;
-    if (log_height < MIN_LOG_HEIGHT) log_height = MIN_LOG_HEIGHT;
+    if (plot_read_version != plot_version) {
+        const Uint64 from = plot_latest > METRICS_PLOT_WINDOW_MS ? plot_latest - METRICS_PLOT_WINDOW_MS : 0;
+        const TimeSeriesResolution resolution = time_series_pick(plot_series, from, plot_latest, METRICS_PLOT_POINTS);
+        const int count = time_series_read(plot_series, resolution, from, plot_latest, plot_points, METRICS_PLOT_POINTS);
+        for (int i = 0; i < count; i++) {
+            plot_values[2 * i] = plot_points[i].min;
+            plot_values[2 * i + 1] = plot_points[i].max;
+        }
+        plot_value_count = 2 * count;
+        plot_read_version = plot_version;
+    }
+
+    ui_plot(ctx, &metrics_plot, plot_values, plot_value_count, plot_version, mu_color(90, 170, 240, 255),
+            mu_color(90, 170, 240, 60));
+    if (plot_value_count == 0) { return; }
+
+    const mu_Rect r = ctx->last_rect;
+    const mu_Font font = ctx->style->font;
+    const mu_Color color = ctx->style->colors[MU_COLOR_TEXT];
+    const int padding = ctx->style->padding;
+    const char *high = frame_format_real("%.4g", metrics_plot.high);
+    const char *low = frame_format_real("%.4g", metrics_plot.low);
+    mu_draw_text(ctx, font, high, -1, mu_vec2(r.x + padding, r.y + padding), color);
+    mu_draw_text(ctx, font, low, -1, mu_vec2(r.x + padding, r.y + r.h - ctx->text_height(font) - padding), color);
+}
 
-    mu_layout_row(ctx, 1, (int[]){-1}, option_height);
+static void draw_log_title(mu_Context *ctx, void *user) {
+    const UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 1, (int[]){-1}, l->option_height);
     mu_text(ctx, "Log Output");
+}
+
+// Follow toggle and jump-to-line
+static void draw_log_controls(mu_Context *ctx, void *user) {
+    UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 3, (int[]){l->slider_label_width + l->option_height, -l->slider_label_width, -1},
+                  l->option_height);
+    mu_checkbox(ctx, "Follow", &log_follow);
+    const int submitted = mu_textbox(ctx, jump_text, sizeof(jump_text)) & MU_RES_SUBMIT;
+    if (mu_button(ctx, "Go") || submitted) {
+        jump_line = mu_max(atol(jump_text) - 1, 0);
+        log_follow = 0;
+        state->dirty |= UI_DIRTY_LOG;
+    }
+}
+
+static unsigned shown_levels(void) {
+    unsigned levels = 0;
+    for (int i = 0; i < LOG_LEVEL_COUNT; i++) {
+        if (level_shown[i]) { levels |= 1u << i; }
+    }
+    return levels;
+}
+
+/*
+ * Panel rows map to line ids: a mapped file's lines are numbered from 0, in-memory lines
+ * keep the ids Logger gave them and the rows only cover the levels being shown.
+ */
+static long log_row_id(const long row) {
+    return mapped_log_is_open() ? row : logger_view_line_id(shown_levels(), (int) row);
+}
+
+// The row showing line id, or the next one shown after it
+static long log_id_row(const long id) {
+    return mapped_log_is_open() ? id : logger_view_find(shown_levels(), id);
+}
+
+static int log_id_shown(const long id) {
+    if (mapped_log_is_open()) { return 1; }
+    const int level = logger_line_level(id);
+    return level >= 0 && level_shown[level];
+}
 
-    mu_layout_row(ctx, 1, (int[]){-1}, log_height);
+// Per-level toggles for the in-memory log, each with the number of lines it holds
+static void draw_log_levels(mu_Context *ctx, void *user) {
+    if (mapped_log_is_open()) { return; }
+
+    static const char *const level_formats[LOG_LEVEL_COUNT] = {"D %ld", "I %ld", "W %ld", "E %ld"};
+    UIState *state = user;
+    const UILayout *l = &state->layout;
+    const int w = mu_get_current_container(ctx)->body.w / LOG_LEVEL_COUNT - ctx->style->spacing;
+    mu_layout_row(ctx, LOG_LEVEL_COUNT, (int[]){w, w, w, -1}, l->option_height);
+    for (int i = 0; i < LOG_LEVEL_COUNT; i++) {
+        const char *label = frame_format_int(level_formats[i], logger_view_count(1u << i));
+        if (ui_toggle(ctx, label, &level_shown[i]) & MU_RES_CHANGE) {
+            log_changed = 1;
+            state->dirty |= UI_DIRTY_LOG;
+        }
+    }
+}
+
+// Moves to the next or previous match, starting from the top of the panel when no match
+// has been picked since the query changed
+static void step_search(UIState *state, const int step) {
+    const int count = log_search_result_count();
+    if (count == 0) { return; }
+
+    int cursor = search_cursor;
+    if (cursor < 0 || cursor >= count) {
+        // Start just before or after the top of the panel
+        cursor = log_search_lower_bound(log_view_top) - (step > 0);
+    }
+    // Matches on hidden levels are passed over
+    for (int tries = 0; tries < count; tries++) {
+        cursor = (cursor + step + count) % count;
+        if (log_id_shown(log_search_result(cursor))) {
+            search_cursor = cursor;
+            break;
+        }
+    }
+    if (search_cursor < 0) { return; }
+    jump_line = log_id_row(log_search_result(search_cursor));
+    log_follow = 0;
+    state->dirty |= UI_DIRTY_LOG;
+}
+
+// Search box with previous/next buttons and the match count; a trailing + means the
+// search is still running
+static void draw_log_search(mu_Context *ctx, void *user) {
+    UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 4, (int[]){-(3 * l->option_height + l->slider_label_width), l->option_height,
+                                  l->option_height, -1}, l->option_height);
+
+    const int res = mu_textbox(ctx, search_text, sizeof(search_text));
+    if (res & MU_RES_CHANGE) {
+        log_search_set_query(search_text);
+        search_cursor = -1;
+        state->dirty |= UI_DIRTY_LOG;
+    }
+    if (mu_button(ctx, "<")) { step_search(state, -1); }
+    if (mu_button(ctx, ">") || (res & MU_RES_SUBMIT)) { step_search(state, 1); }
+
+    if (search_text[0] == '\0') {
+        mu_label(ctx, "");
+        return;
+    }
+    const int count = log_search_result_count();
+    const char *more = log_search_busy() ? "+" : "";
+    if (search_cursor >= 0 && search_cursor < count) {
+        mu_label(ctx, frame_printf("%d/%d%s", search_cursor + 1, count, more));
+    } else {
+        mu_label(ctx, frame_printf("%d%s", count, more));
+    }
+}
+
+static void begin_log_panel(mu_Context *ctx, void *user) {
+    const UIState *state = user;
+    const UILayout *l = &state->layout;
+    mu_layout_row(ctx, 1, (int[]){-1}, l->log_height);
     mu_begin_panel(ctx, "Log Panel");
-    mu_Container *panel = mu_get_current_container(ctx);
+    const mu_Container *panel = mu_get_current_container(ctx);
 
     mu_draw_rect(ctx, panel->rect, mu_color(20, 20, 20, 255));
     mu_layout_row(ctx, 1, (int[]){-1}, ctx->text_height(ctx->style->font));
+}
 
-    const char *logbuf = get_log_buffer();
-    if (logbuf[0]) {
-        mu_text(ctx, logbuf);
-    }
+static int log_pitch(const mu_Context *ctx) {
+    return ctx->text_height(ctx->style->font) + ctx->style->spacing;
+}
 
-    if (is_log_updated()) {
-        panel->scroll.y = panel->content_size.y;
-        reset_log_updated();
+// Scroll offsets are ints, which bounds how many rows the panel can span
+static long log_line_count(const mu_Context *ctx) {
+    const long count = mapped_log_is_open() ? mapped_log_line_count() : logger_view_count(shown_levels());
+    return mu_min(count, (INT_MAX / 2) / log_pitch(ctx));
+}
+
+// Mapped lines are drawn straight from the file; in-memory records are formatted first
+static void draw_log_row(mu_Context *ctx, const mu_Rect r, const long id, char *scratch) {
+    int len;
+    const char *text;
+    if (mapped_log_is_open()) {
+        text = mapped_log_line(id, &len);
+    } else {
+        len = logger_format_line_id(id, scratch, LOG_LINE_MAX, 0);
+        text = len >= 0 ? scratch : NULL;
     }
+    if (text == NULL) { return; }
 
-    mu_end_panel(ctx);
+    const mu_Font font = ctx->style->font;
+    const mu_Vec2 pos = mu_vec2(r.x + ctx->style->padding, r.y + (r.h - ctx->text_height(font)) / 2);
+    mu_draw_text(ctx, font, text, mu_min(len, LOG_LINE_MAX - 1), pos, ctx->style->colors[MU_COLOR_TEXT]);
 }
 
-static void draw_menu_header(mu_Context *ctx, UIState *state, const int menu_width, const int header_height,
-                             const int close_button_size) {
-    mu_layout_row(ctx, 2, (int[]){menu_width - close_button_size - HEADER_TEXT_PADDING, close_button_size},
-                  header_height);
+// Only the lines inside the panel are drawn; the rows above and below collapse into one
+// spacer each, which keeps the content height and scroll range of the full log
+static void draw_log_text(mu_Context *ctx, void *user) {
+    const long count = log_line_count(ctx);
+    if (count == 0) { return; }
+
+    const mu_Container *panel = mu_get_current_container(ctx);
+    const int line_height = ctx->text_height(ctx->style->font);
+    const int pitch = log_pitch(ctx);
+    const long first = mu_clamp(panel->scroll.y / pitch, 0, count - 1);
+    const long last = mu_min(count, (panel->scroll.y + panel->body.h) / pitch + 1);
+
+    if (first > 0) {
+        mu_layout_row(ctx, 1, (int[]){-1}, (int) (first * pitch) - ctx->style->spacing);
+        mu_layout_next(ctx);
+    }
 
-    // Draw title
-    mu_layout_begin_column(ctx); {
-        const int title_width = ctx->text_width(ctx->style->font, TITLE_TEXT, strlen(TITLE_TEXT));
-        const int title_height = ctx->text_height(ctx->style->font);
-        const int text_x = (menu_width - close_button_size - HEADER_TEXT_PADDING - title_width) / DIVIDE_BY_TWO;
-        const int text_y = (header_height - title_height) / DIVIDE_BY_TWO;
+    // Rows and matches both ascend by id, so one pass over each lines them up
+    const long current = log_search_result(search_cursor);
+    const int matches = search_text[0] != '\0' ? log_search_result_count() : 0;
+    log_view_top = log_row_id(first);
+    int match = log_search_lower_bound(log_view_top);
+
+    mu_layout_row(ctx, 1, (int[]){-1}, line_height);
+    char line[LOG_LINE_MAX];
+    for (long i = first; i < last; i++) {
+        const mu_Rect r = mu_layout_next(ctx);
+        const long id = log_row_id(i);
+        while (match < matches && log_search_result(match) < id) { match++; }
+        if (match < matches && log_search_result(match) == id) {
+            mu_draw_rect(ctx, r, id == current ? mu_color(90, 75, 20, 255) : mu_color(50, 45, 25, 255));
+        }
+        draw_log_row(ctx, r, id, line);
+    }
 
-        mu_draw_text(ctx, ctx->style->font, TITLE_TEXT, strlen(TITLE_TEXT),
-                     mu_vec2(text_x, text_y),
-                     mu_color(230, 230, 230, 255));
+    if (last < count) {
+        mu_layout_row(ctx, 1, (int[]){-1}, (int) ((count - last) * pitch) - ctx->style->spacing);
+        mu_layout_next(ctx);
     }
-    mu_layout_end_column(ctx);
+}
 
-    // Draw close button
-    mu_layout_begin_column(ctx); {
-        const int button_padding = (header_height - close_button_size) / DIVIDE_BY_TWO;
-        mu_layout_set_next(ctx, mu_rect(menu_width - close_button_size - 5, button_padding,
-                                        close_button_size, close_button_size), 0);
-        if (mu_button_ex(ctx, "X", 0, MU_OPT_ALIGNCENTER)) {
-            state->menu_open = 0;
-        }
+static void end_log_panel(mu_Context *ctx, void *user) {
+    mu_Container *panel = mu_get_current_container(ctx);
+    if (jump_line >= 0) {
+        panel->scroll.y = (int) (mu_min(jump_line, log_line_count(ctx) - 1) * log_pitch(ctx));
+        jump_line = -1;
+    } else if (log_follow) {
+        // A followed log stays pinned to its end; uncheck Follow to scroll through it
+        panel->scroll.y = panel->content_size.y;
     }
-    mu_layout_end_column(ctx);
+    log_changed = 0;
+
+    mu_end_panel(ctx);
+}
+
+void menu_init(UIState *state) {
+    ui_tree_init(&menu_tree, &state->dirty);
+
+    const int header = ui_tree_add(&menu_tree, -1, draw_header_row, NULL, state, 0, 0);
+    ui_tree_add(&menu_tree, header, draw_header_title, NULL, state, UI_DIRTY_LAYOUT, 0);
+    ui_tree_add(&menu_tree, header, draw_header_close, NULL, state, 0, UI_NODE_INTERACTIVE);
+
+    ui_tree_add(&menu_tree, -1, draw_separator, NULL, state, UI_DIRTY_LAYOUT, 0);
+    ui_tree_add(&menu_tree, -1, draw_options_title, NULL, state, 0, 0);
+    ui_tree_add(&menu_tree, -1, draw_options, NULL, state, 0, UI_NODE_INTERACTIVE);
+    ui_tree_add(&menu_tree, -1, draw_color_title, NULL, state, 0, 0);
+    ui_tree_add(&menu_tree, -1, draw_color_sliders, NULL, state, UI_DIRTY_STATE, UI_NODE_INTERACTIVE);
+    ui_tree_add(&menu_tree, -1, draw_color_preview, NULL, state, UI_DIRTY_STATE, 0);
+    ui_tree_add(&menu_tree, -1, draw_metrics_title, NULL, state, 0, UI_NODE_INTERACTIVE);
+    ui_tree_add(&menu_tree, -1, draw_metrics_controls, NULL, state, UI_DIRTY_METRICS, UI_NODE_INTERACTIVE);
+    ui_tree_add(&menu_tree, -1, draw_metrics_plot, NULL, state, UI_DIRTY_METRICS, 0);
+    ui_tree_add(&menu_tree, -1, draw_log_title, NULL, state, 0, 0);
+    ui_tree_add(&menu_tree, -1, draw_log_controls, NULL, state, 0, UI_NODE_INTERACTIVE);
+    ui_tree_add(&menu_tree, -1, draw_log_search, NULL, state, 0, UI_NODE_INTERACTIVE);
+    ui_tree_add(&menu_tree, -1, draw_log_levels, NULL, state, 0, UI_NODE_INTERACTIVE);
+
+    const int log_panel = ui_tree_add(&menu_tree, -1, begin_log_panel, end_log_panel, state, 0, 0);
+    ui_tree_add(&menu_tree, log_panel, draw_log_text, NULL, state, UI_DIRTY_LOG, 0);
 }
 
 void draw_menu(mu_Context *ctx, UIState *state) {
-    int menu_width = state->window_width / MENU_WIDTH_RATIO;
-    if (menu_width < MIN_MENU_WIDTH) menu_width = MIN_MENU_WIDTH;
+    const UILayout *l = &state->layout;
+    const int menu_width = l->menu_width;
 
     int x_pos = (int) (-menu_width + menu_width * state->menu_animation);
     x_pos = mu_clamp(x_pos, -menu_width, 0);
 
-    int header_height = state->window_height / HEADER_HEIGHT_RATIO;
-    if (header_height < MIN_HEADER_HEIGHT) header_height = MIN_HEADER_HEIGHT;
-    const int close_button_size = header_height - CLOSE_BUTTON_PADDING;
+    if (is_log_updated()) {
+        reset_log_updated();
+        log_changed = 1;
+    }
+    if (mapped_log_take_update()) {
+        log_changed = 1;
+    }
+    if (log_search_take_update()) {
+        state->dirty |= UI_DIRTY_LOG;
+    }
+    if (log_changed) {
+        state->dirty |= UI_DIRTY_LOG;
+    }
+    if (plot_shown && time_series_count() > 0 && time_series_latest(plot_series) != plot_latest) {
+        plot_latest = time_series_latest(plot_series);
+        plot_version++;
+        state->dirty |= UI_DIRTY_METRICS;
+    }
 
-    if (mu_begin_window_ex(ctx, "Open Menu", mu_rect(x_pos, 0, menu_width, state->window_height),
-                           MU_OPT_NOCLOSE | MU_OPT_NOTITLE | MU_OPT_NORESIZE | MU_OPT_NOSCROLL)) {
-        mu_Container *win = mu_get_current_container(ctx);
-        win->rect.x = x_pos;
-        win->rect.w = menu_width;
-        win->rect.h = state->window_height;
+    // Placed before the window begins so its frame, body and contents all move together
+    const mu_Rect menu_rect = mu_rect(x_pos, 0, menu_width, state->window_height);
+    mu_get_container(ctx, "Open Menu")->rect = menu_rect;
+    if (mu_begin_window_ex(ctx, "Open Menu", menu_rect,
+                           MU_OPT_NOCLOSE | MU_OPT_NOTITLE | MU_OPT_NORESIZE | MU_OPT_NOSCROLL | MU_OPT_NOFRAME)) {
+        // MicroUI clips windows at x = 0, which would reshape the menu every slide frame; clip
+        // to the window itself so it stays the same segment as it moves
+        mu_Rect *clip = &ctx->clip_stack.items[ctx->clip_stack.idx - 1];
+        *clip = mu_rect(menu_rect.x - 1, menu_rect.y - 1, menu_rect.w + 2, menu_rect.h + 2);
+        ctx->draw_frame(ctx, menu_rect, MU_COLOR_WINDOWBG);
+        *clip = menu_rect;
 
         // Draw background and header
-        mu_draw_rect(ctx, mu_rect(0, 0, menu_width, state->window_height), mu_color(30, 30, 30, 255));
-        mu_draw_rect(ctx, mu_rect(0, 0, menu_width, header_height), mu_color(40, 40, 40, 255));
+        mu_draw_rect(ctx, menu_rect, mu_color(30, 30, 30, 255));
+        mu_draw_rect(ctx, mu_rect(menu_rect.x, menu_rect.y, menu_width, l->header_height), mu_color(40, 40, 40, 255));
 
-        draw_menu_header(ctx, state, menu_width, header_height, close_button_size);
-        draw_menu_content(ctx, state, menu_width, header_height);
+        menu_tree.retained = state->retained_ui;
+        ui_tree_emit(&menu_tree, ctx);
 
         mu_end_window(ctx);
     }
@@ -144,11 +523,10 @@ void draw_menu(mu_Context *ctx, UIState *state) {
 
 void draw_menu_button(mu_Context *ctx, UIState *state) {
     if (!state->menu_open && state->menu_animation == 0.0f) {
-        const int button_x = state->window_width / BUTTON_X_RATIO;
-        const int button_y = state->window_height / BUTTON_Y_RATIO;
+        const UILayout *l = &state->layout;
 
         if (mu_begin_window_ex(ctx, "MenuButton",
-                               mu_rect(button_x, button_y, state->button_width, state->button_height),
+                               mu_rect(l->button_x, l->button_y, l->button_width, l->button_height),
                                MU_OPT_NOCLOSE | MU_OPT_NOTITLE | MU_OPT_NORESIZE |
                                MU_OPT_NOSCROLL | MU_OPT_NOFRAME)) {
             const mu_Container *cnt = mu_get_current_container(ctx);
@@ -157,6 +535,7 @@ void draw_menu_button(mu_Context *ctx, UIState *state) {
             mu_layout_row(ctx, 1, (int[]){-1}, -1);
             if (mu_button_ex(ctx, "Open Menu", 0, MU_OPT_ALIGNCENTER | MU_OPT_NOFRAME)) {
                 state->menu_open = 1;
+                state->dirty |= UI_DIRTY_STATE;
             }
 
             mu_end_window(ctx);
@@ -4,6 +4,8 @@
 #include "microui.h"
 #include "src/GUI/UiState.h"
 
+void menu_init(UIState *state);
+
 void draw_menu(mu_Context *ctx, UIState *state);
 
 void draw_menu_button(mu_Context *ctx, UIState *state);
@@ -0,0 +1,138 @@
+#include "Plot.h"
+#include "src/Config/CommandBuffer.h"
+#include "src/Config/Renderer.h"
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Lowest and highest of count > 0 values
+static void min_max(const float *values, const int count, float *low, float *high) {
+    float lo = values[0], hi = values[0];
+    int i = 0;
+
+#ifdef __SSE2__
+    if (count >= 8) {
+        // Two sets of accumulators so consecutive loads don't wait on each other
+        __m128 lo0 = _mm_loadu_ps(values), hi0 = lo0;
+        __m128 lo1 = _mm_loadu_ps(values + 4), hi1 = lo1;
+        for (i = 8; i + 8 <= count; i += 8) {
+            const __m128 a = _mm_loadu_ps(values + i);
+            const __m128 b = _mm_loadu_ps(values + i + 4);
+            lo0 = _mm_min_ps(lo0, a);
+            hi0 = _mm_max_ps(hi0, a);
+            lo1 = _mm_min_ps(lo1, b);
+            hi1 = _mm_max_ps(hi1, b);
+        }
+        __m128 l = _mm_min_ps(lo0, lo1), h = _mm_max_ps(hi0, hi1);
+        l = _mm_min_ps(l, _mm_movehl_ps(l, l));
+        h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+        lo = _mm_cvtss_f32(_mm_min_ss(l, _mm_shuffle_ps(l, l, 1)));
+        hi = _mm_cvtss_f32(_mm_max_ss(h, _mm_shuffle_ps(h, h, 1)));
+    }
+#endif
+
+    for (; i < count; i++) {
+        if (values[i] < lo) { lo = values[i]; }
+        if (values[i] > hi) { hi = values[i]; }
+    }
+    *low = lo;
+    *high = hi;
+}
+
+// Each column takes the min and max of the values that fall under it. With fewer values
+// than columns, the line between neighbouring values is sampled instead.
+static void decimate(UiPlot *plot, const float *values, const int count, const int columns) {
+    if (count >= columns) {
+        for (int i = 0; i < columns; i++) {
+            const int begin = (int) ((long long) i * count / columns);
+            const int end = (int) ((long long) (i + 1) * count / columns);
+            min_max(values + begin, end - begin, &plot->column_min[i], &plot->column_max[i]);
+        }
+        return;
+    }
+
+    for (int i = 0; i < columns; i++) {
+        const float t = columns > 1 ? (float) i * (count - 1) / (columns - 1) : 0.0f;
+        const int j = (int) t;
+        const int k = j + 1 < count ? j + 1 : j;
+        const float value = values[j] + (values[k] - values[j]) * (t - j);
+        plot->column_min[i] = value;
+        plot->column_max[i] = value;
+    }
+}
+
+static int row_of(const float value, const float low, const float scale, const int height) {
+    return height - 1 - (int) ((value - low) * scale + 0.5f);
+}
+
+static void build_spans(UiPlot *plot, const int columns, const int height) {
+    float low, high, unused;
+    min_max(plot->column_min, columns, &low, &unused);
+    min_max(plot->column_max, columns, &unused, &high);
+    if (!(high > low)) {
+        low -= 1.0f;
+        high += 1.0f;
+    }
+    plot->low = low;
+    plot->high = high;
+
+    const float scale = (height - 1) / (high - low);
+    int prev_top = 0, prev_bottom = 0;
+    for (int i = 0; i < columns; i++) {
+        const int own_top = row_of(plot->column_max[i], low, scale, height);
+        const int own_bottom = row_of(plot->column_min[i], low, scale, height);
+
+        // Reach back to the previous column so a step between them stays one connected line
+        int top = own_top, bottom = own_bottom;
+        if (i > 0 && top > prev_bottom + 1) { top = prev_bottom + 1; }
+        if (i > 0 && bottom < prev_top - 1) { bottom = prev_top - 1; }
+
+        plot->spans[2 * i] = (short) top;
+        plot->spans[2 * i + 1] = (short) bottom;
+        prev_top = own_top;
+        prev_bottom = own_bottom;
+    }
+}
+
+void ui_plot(mu_Context *ctx, UiPlot *plot, const float *values, const int count, const unsigned version,
+             const mu_Color color, const mu_Color fill) {
+    const mu_Rect r = mu_layout_next(ctx);
+    mu_draw_rect(ctx, r, ctx->style->colors[MU_COLOR_BASE]);
+    const int columns = mu_min(r.w, UI_PLOT_MAX_COLUMNS);
+    const int height = mu_min(r.h, SHRT_MAX);
+    if (count <= 0 || columns <= 0 || height <= 0) { return; }
+
+    if (!plot->valid || plot->version != version || plot->count != count || plot->width != columns ||
+        plot->height != height) {
+        decimate(plot, values, count, columns);
+        build_spans(plot, columns, height);
+        plot->valid = 1;
+        plot->version = version;
+        plot->count = count;
+        plot->width = columns;
+        plot->height = height;
+    }
+
+    const mu_Rect rect = mu_rect(r.x, r.y, columns, height);
+    const int clipped = mu_check_clip(ctx, rect);
+    if (clipped == MU_CLIP_ALL) { return; }
+    if (clipped == MU_CLIP_PART) { mu_set_clip(ctx, mu_get_clip_rect(ctx)); }
+
+    const int spans_size = 2 * (int) sizeof(short) * columns;
+    const int used = (int) offsetof(PolylineCommand, spans) + spans_size;
+    const int size = (used + _Alignof(mu_Command) - 1) / _Alignof(mu_Command) * _Alignof(mu_Command);
+    PolylineCommand *line = (PolylineCommand *) mu_push_command(ctx, COMMAND_POLYLINE, size);
+    line->rect = rect;
+    line->color = color;
+    line->fill = fill;
+    line->columns = columns;
+    memcpy(line->spans, plot->spans, spans_size);
+    // Zero the alignment padding so equal frames are byte-identical
+    memset((char *) line + used, 0, size - used);
+
+    if (clipped) { mu_set_clip(ctx, mu_rect(0, 0, R_UNCLIPPED_SIZE, R_UNCLIPPED_SIZE)); }
+}
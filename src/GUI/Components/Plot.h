@@ -0,0 +1,34 @@
+#ifndef PLOT_H
+#define PLOT_H
+
+#include "microui.h"
+#include "src/Config/CommandBuffer.h"
+
+#define UI_PLOT_MAX_COLUMNS COMMAND_POLYLINE_MAX_COLUMNS
+
+// What a plot last drew: the min and max of the values under each pixel column, the
+// column spans derived from them and the key they were built for. Keep one per plot,
+// zero-initialized; low and high hold the value range of the last draw.
+typedef struct {
+    int valid;
+    unsigned version;
+    int count;
+    int width;
+    int height;
+    float low;
+    float high;
+    float column_min[UI_PLOT_MAX_COLUMNS];
+    float column_max[UI_PLOT_MAX_COLUMNS];
+    short spans[2 * UI_PLOT_MAX_COLUMNS];
+} UiPlot;
+
+// Line plot of count finite values across the next layout rect, drawn over MU_COLOR_BASE,
+// scaled to their range and emitted as a single polyline command. The values under each
+// pixel column are reduced to their min and max, so any count costs one command of two
+// shorts per column. That work is cached in plot until version, count or the rect's size
+// changes, so bump version whenever the values do. A fill that isn't transparent turns it
+// into an area plot.
+void ui_plot(mu_Context *ctx, UiPlot *plot, const float *values, int count, unsigned version, mu_Color color,
+             mu_Color fill);
+
+#endif
@@ -0,0 +1,40 @@
+#include "Widgets.h"
+#include "src/GUI/FrameArena.h"
+
+int ui_slider(mu_Context *ctx, mu_Real *value, const mu_Real low, const mu_Real high) {
+    // MicroUI always formats the value itself; an empty format makes that free and the
+    // label is drawn over the same rect. While the slider is being typed into it shows
+    // MicroUI's textbox, which must stay uncovered.
+    const mu_Id id = mu_get_id(ctx, &value, sizeof(value));
+    const int res = mu_slider_ex(ctx, value, low, high, 0, "", MU_OPT_ALIGNCENTER);
+    if (ctx->number_edit != id) {
+        mu_draw_control_text(ctx, frame_format_real(MU_SLIDER_FMT, *value), ctx->last_rect, MU_COLOR_TEXT,
+                             MU_OPT_ALIGNCENTER);
+    }
+    return res;
+}
+
+int ui_toggle(mu_Context *ctx, const char *label, int *on) {
+    const mu_Id id = mu_get_id(ctx, &on, sizeof(on));
+    const mu_Rect r = mu_layout_next(ctx);
+    mu_update_control(ctx, id, r, 0);
+
+    int res = 0;
+    if (ctx->mouse_pressed == MU_MOUSE_LEFT && ctx->focus == id) {
+        *on = !*on;
+        res |= MU_RES_CHANGE;
+    }
+
+    mu_draw_control_frame(ctx, id, r, MU_COLOR_BUTTON, 0);
+    mu_Color color = ctx->style->colors[MU_COLOR_TEXT];
+    if (!*on) {
+        color = mu_color(color.r / 2, color.g / 2, color.b / 2, color.a);
+    }
+    const mu_Font font = ctx->style->font;
+    const int width = ctx->text_width(font, label, -1);
+    mu_push_clip_rect(ctx, r);
+    mu_draw_text(ctx, font, label, -1,
+                 mu_vec2(r.x + (r.w - width) / 2, r.y + (r.h - ctx->text_height(font)) / 2), color);
+    mu_pop_clip_rect(ctx);
+    return res;
+}
@@ -0,0 +1,14 @@
+#ifndef WIDGETS_H
+#define WIDGETS_H
+
+#include "microui.h"
+
+// mu_slider with its value label taken from the frame format cache instead of formatted
+// by MicroUI every frame
+int ui_slider(mu_Context *ctx, mu_Real *value, mu_Real low, mu_Real high);
+
+// Button that flips *on when clicked; while off its label is dimmed. Returns MU_RES_CHANGE
+// on the click.
+int ui_toggle(mu_Context *ctx, const char *label, int *on);
+
+#endif
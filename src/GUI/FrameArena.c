@@ -0,0 +1,118 @@
+#include "FrameArena.h"
+#include "src/Systems/Profiler.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define FORMAT_CACHE_PROBES 4
+
+typedef struct {
+    const char *fmt;
+    uint64_t key;
+    // Frame the text was last handed out in; 0 marks an empty entry
+    unsigned frame;
+    char text[FORMAT_CACHE_TEXT];
+} FormatEntry;
+
+static char arena[FRAME_ARENA_SIZE];
+static size_t arena_used;
+static unsigned frame = 1;
+static FormatEntry cache[FORMAT_CACHE_SIZE];
+
+void frame_arena_reset(void) {
+    arena_used = 0;
+    frame++;
+}
+
+const char *frame_vprintf(const char *fmt, va_list args) {
+    char *dst = arena + arena_used;
+    const size_t space = FRAME_ARENA_SIZE - arena_used;
+    const int length = vsnprintf(dst, space, fmt, args);
+    if (length < 0 || (size_t) length >= space) {
+        profiler_count(PROFILER_ARENA_OVERFLOWS, 1);
+        return "";
+    }
+    arena_used += length + 1;
+    return dst;
+}
+
+const char *frame_printf(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    const char *res = frame_vprintf(fmt, args);
+    va_end(args);
+    return res;
+}
+
+// Finds the entry for (fmt, key), or the least recently used one it may replace. Entries
+// handed out this frame are never replaced since their text must stay valid.
+static FormatEntry *lookup(const char *fmt, const uint64_t key, int *hit) {
+    // Doubles differ mostly in their top bits, so the key is mixed fully (MurmurHash3 fmix64)
+    uint64_t hash = key ^ (uintptr_t) fmt;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    const unsigned base = (unsigned) hash;
+    FormatEntry *victim = NULL;
+    for (int i = 0; i < FORMAT_CACHE_PROBES; i++) {
+        FormatEntry *entry = &cache[(base + i) % FORMAT_CACHE_SIZE];
+        if (entry->frame != 0 && entry->fmt == fmt && entry->key == key) {
+            *hit = 1;
+            return entry;
+        }
+        if (entry->frame != frame && (victim == NULL || entry->frame < victim->frame)) {
+            victim = entry;
+        }
+    }
+    *hit = 0;
+    return victim;
+}
+
+static const char *store(FormatEntry *entry, const char *fmt, const uint64_t key, const int length) {
+    if (length < 0 || length >= FORMAT_CACHE_TEXT) {
+        entry->frame = 0;
+        return NULL;
+    }
+    entry->fmt = fmt;
+    entry->key = key;
+    entry->frame = frame;
+    profiler_count(PROFILER_FORMAT_MISSES, 1);
+    return entry->text;
+}
+
+const char *frame_format_int(const char *fmt, const long value) {
+    int hit;
+    const uint64_t key = (uint64_t) value;
+    FormatEntry *entry = lookup(fmt, key, &hit);
+    if (entry != NULL && hit) {
+        entry->frame = frame;
+        profiler_count(PROFILER_FORMAT_HITS, 1);
+        return entry->text;
+    }
+
+    const char *res = NULL;
+    if (entry != NULL) {
+        res = store(entry, fmt, key, snprintf(entry->text, sizeof(entry->text), fmt, value));
+    }
+    return res != NULL ? res : frame_printf(fmt, value);
+}
+
+const char *frame_format_real(const char *fmt, const double value) {
+    int hit;
+    uint64_t key;
+    memcpy(&key, &value, sizeof(key));
+    FormatEntry *entry = lookup(fmt, key, &hit);
+    if (entry != NULL && hit) {
+        entry->frame = frame;
+        profiler_count(PROFILER_FORMAT_HITS, 1);
+        return entry->text;
+    }
+
+    const char *res = NULL;
+    if (entry != NULL) {
+        res = store(entry, fmt, key, snprintf(entry->text, sizeof(entry->text), fmt, value));
+    }
+    return res != NULL ? res : frame_printf(fmt, value);
+}
@@ -0,0 +1,28 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include "src/Constants.h"
+#include <stdarg.h>
+
+#define FRAME_ARENA_SIZE (16 * 1024)
+#define FORMAT_CACHE_SIZE 64
+#define FORMAT_CACHE_TEXT 32
+
+// Formatted strings for widget labels. Everything returned stays valid until the next
+// frame_arena_reset, which runs right before mu_begin, so labels can be built without a
+// stack buffer or an allocation.
+void frame_arena_reset(void);
+
+// Returns "" once the arena is full
+const char *frame_printf(const char *fmt, ...) PRINTF_FORMAT(1, 2);
+
+const char *frame_vprintf(const char *fmt, va_list args);
+
+// Cached single-value formatting: a value that was formatted with the same fmt in a
+// recent frame isn't formatted again. Entries are keyed on the fmt pointer, so pass a
+// string literal and use each one with a single value type.
+const char *frame_format_int(const char *fmt, long value);
+
+const char *frame_format_real(const char *fmt, double value);
+
+#endif
@@ -1,16 +1,30 @@
 #include "UiState.h"
 #include "src/Constants.h"
+#include <string.h>
+
+static int at_least(const int value, const int min) {
+    return value < min ? min : value;
+}
+
+static int clamp_dimension(const int value, const int min, const int max) {
+    if (value < min) return min;
+    if (value > max) return max;
+    return value;
+}
 
 void ui_state_init(UIState *state) {
     state->window_width = DEFAULT_WINDOW_WIDTH;
     state->window_height = DEFAULT_WINDOW_HEIGHT;
+    state->scale = 1;
     state->menu_open = 0;
     state->menu_animation = 0.0f;
-    state->button_width = MIN_BUTTON_WIDTH;
-    state->button_height = MIN_BUTTON_HEIGHT;
+    memset(&state->layout, 0, sizeof(state->layout));
     state->bg_color[0] = 19;
     state->bg_color[1] = 19;
     state->bg_color[2] = 19;
+    state->retained_ui = 0;
+    state->dirty = UI_DIRTY_STATE | UI_DIRTY_LOG | UI_DIRTY_LAYOUT | UI_DIRTY_METRICS;
+    calculate_responsive_dimensions(state);
 }
 
 void ui_state_update_dimensions(UIState *state, const int width, const int height) {
@@ -19,12 +33,40 @@ void ui_state_update_dimensions(UIState *state, const int width, const int heigh
     calculate_responsive_dimensions(state);
 }
 
+void ui_state_set_scale(UIState *state, const int scale) {
+    state->scale = clamp_dimension(scale, 1, MAX_UI_SCALE);
+    calculate_responsive_dimensions(state);
+}
+
 void calculate_responsive_dimensions(UIState *state) {
-    state->button_width = state->window_width / BUTTON_WIDTH_RATIO;
-    if (state->button_width < MIN_BUTTON_WIDTH) state->button_width = MIN_BUTTON_WIDTH;
-    if (state->button_width > MAX_BUTTON_WIDTH) state->button_width = MAX_BUTTON_WIDTH;
+    // Window dimensions are in drawable pixels; fixed sizes are in points and scaled here
+    const int w = state->window_width;
+    const int h = state->window_height;
+    const int s = state->scale;
+    UILayout next = state->layout;
+
+    next.menu_width = at_least(w / MENU_WIDTH_RATIO, MIN_MENU_WIDTH * s);
+    next.header_height = at_least(h / HEADER_HEIGHT_RATIO, MIN_HEADER_HEIGHT * s);
+    next.header_text_padding = HEADER_TEXT_PADDING * s;
+    next.close_button_size = next.header_height - CLOSE_BUTTON_PADDING * s;
+    next.close_button_x = next.menu_width - next.close_button_size - CLOSE_BUTTON_MARGIN * s;
+    next.separator_x = MENU_PADDING_X * s;
+    next.separator_y = next.header_height + HEADER_SEPARATOR_Y_OFFSET * s;
+    next.separator_width = next.menu_width - MENU_CONTENT_WIDTH_OFFSET * s;
+    next.separator_height = SEPARATOR_HEIGHT * s;
+    next.option_height = at_least(h / OPTION_HEIGHT_RATIO, MIN_OPTION_HEIGHT * s);
+    next.slider_label_width = SLIDER_LABEL_WIDTH * s;
+    next.log_height = at_least(h / LOG_HEIGHT_RATIO, MIN_LOG_HEIGHT * s);
+    next.plot_height = at_least(h / PLOT_HEIGHT_RATIO, MIN_PLOT_HEIGHT * s);
+
+    next.button_x = w / BUTTON_X_RATIO;
+    next.button_y = h / BUTTON_Y_RATIO;
+    next.button_width = clamp_dimension(w / BUTTON_WIDTH_RATIO, MIN_BUTTON_WIDTH * s, MAX_BUTTON_WIDTH * s);
+    next.button_height = clamp_dimension(h / BUTTON_HEIGHT_RATIO, MIN_BUTTON_HEIGHT * s, MAX_BUTTON_HEIGHT * s);
 
-    state->button_height = state->window_height / BUTTON_HEIGHT_RATIO;
-    if (state->button_height < MIN_BUTTON_HEIGHT) state->button_height = MIN_BUTTON_HEIGHT;
-    if (state->button_height > MAX_BUTTON_HEIGHT) state->button_height = MAX_BUTTON_HEIGHT;
+    if (memcmp(&next, &state->layout, sizeof(next)) != 0) {
+        next.generation = state->layout.generation + 1;
+        state->layout = next;
+        state->dirty |= UI_DIRTY_LAYOUT;
+    }
 }
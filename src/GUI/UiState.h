@@ -1,20 +1,54 @@
 #ifndef UI_STATE_H
 #define UI_STATE_H
 
+enum {
+    UI_DIRTY_STATE = (1 << 0),
+    UI_DIRTY_LOG = (1 << 1),
+    UI_DIRTY_LAYOUT = (1 << 2),
+    UI_DIRTY_METRICS = (1 << 3)
+};
+
+// Geometry derived from the window size and scale; only recomputed when either changes.
+// generation is bumped whenever any value actually changes.
+typedef struct {
+    int menu_width;
+    int header_height;
+    int header_text_padding;
+    int close_button_size;
+    int close_button_x;
+    int separator_x;
+    int separator_y;
+    int separator_width;
+    int separator_height;
+    int option_height;
+    int slider_label_width;
+    int log_height;
+    int plot_height;
+    int button_x;
+    int button_y;
+    int button_width;
+    int button_height;
+    unsigned generation;
+} UILayout;
+
 typedef struct {
     int window_width;
     int window_height;
+    int scale;
     int menu_open;
     float menu_animation;
-    int button_width;
-    int button_height;
+    UILayout layout;
     float bg_color[3];
+    int retained_ui;
+    unsigned dirty;
 } UIState;
 
 void ui_state_init(UIState *state);
 
 void ui_state_update_dimensions(UIState *state, int width, int height);
 
+void ui_state_set_scale(UIState *state, int scale);
+
 void calculate_responsive_dimensions(UIState *state);
 
 #endif
@@ -0,0 +1,184 @@
+#include "UiTree.h"
+#include <stdio.h>
+#include <string.h>
+
+void ui_tree_init(UiTree *tree, unsigned *dirty) {
+    tree->count = 0;
+    tree->retained = 0;
+    tree->dirty = dirty;
+    tree->cache_idx = 0;
+    tree->front = 0;
+    tree->rebuilt = 0;
+    tree->reused = 0;
+}
+
+int ui_tree_add(UiTree *tree, const int parent, const UiNodeFn draw, const UiNodeFn end, void *user,
+                const unsigned deps, const int flags) {
+    if (tree->count >= UI_TREE_MAX_NODES) {
+        fprintf(stderr, "UI tree node limit reached\n");
+        return -1;
+    }
+
+    const int id = tree->count++;
+    UiNode *node = &tree->nodes[id];
+    memset(node, 0, sizeof(*node));
+    node->draw = draw;
+    node->end = end;
+    node->user = user;
+    node->deps = deps;
+    node->flags = flags;
+    node->parent = parent;
+    node->first_child = -1;
+    node->last_child = -1;
+    node->next_sibling = -1;
+    node->dirty = 1;
+
+    if (parent >= 0) {
+        UiNode *p = &tree->nodes[parent];
+        if (p->last_child >= 0) {
+            tree->nodes[p->last_child].next_sibling = id;
+        } else {
+            p->first_child = id;
+        }
+        p->last_child = id;
+    }
+    return id;
+}
+
+void ui_tree_mark_dirty(UiTree *tree, const int node) {
+    UiNode *n = &tree->nodes[node];
+    n->dirty = 1;
+    for (int child = n->first_child; child >= 0; child = tree->nodes[child].next_sibling) {
+        ui_tree_mark_dirty(tree, child);
+    }
+}
+
+static int rects_equal(const mu_Rect a, const mu_Rect b) {
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+static int point_in_rect(const mu_Rect r, const mu_Vec2 p) {
+    return p.x >= r.x && p.x < r.x + r.w && p.y >= r.y && p.y < r.y + r.h;
+}
+
+static mu_Layout *current_layout(mu_Context *ctx) {
+    return &ctx->layout_stack.items[ctx->layout_stack.idx - 1];
+}
+
+// Interactive leaves are re-run while the pointer is on (or just left) them, or while any
+// widget holds focus, so hover/focus/click handling inside MicroUI keeps working.
+static int needs_input(const mu_Context *ctx, const UiNode *node) {
+    if (!(node->flags & UI_NODE_INTERACTIVE)) { return 0; }
+    if (ctx->focus) { return 1; }
+    return point_in_rect(node->bounds, ctx->mouse_pos) || point_in_rect(node->bounds, ctx->last_mouse_pos);
+}
+
+static int store_span(UiTree *tree, UiNode *node, const char *src, const int size) {
+    if (size <= 0 || tree->cache_idx + size > UI_TREE_CACHE_SIZE) { return 0; }
+    memcpy(tree->cache[!tree->front] + tree->cache_idx, src, size);
+    node->cmd_offset = tree->cache_idx;
+    node->cmd_size = size;
+    tree->cache_idx += size;
+    return 1;
+}
+
+static int span_has_jump(const char *span, const int size) {
+    for (int offset = 0; offset < size;) {
+        const mu_Command *cmd = (const mu_Command *) (span + offset);
+        if (cmd->type == MU_COMMAND_JUMP) { return 1; }
+        offset += cmd->base.size;
+    }
+    return 0;
+}
+
+static void replay_leaf(UiTree *tree, mu_Context *ctx, UiNode *node) {
+    const char *src = tree->cache[tree->front] + node->cmd_offset;
+
+    // One push reserves the whole span; the memcpy then lays down every cached command header
+    mu_Command *dst = mu_push_command(ctx, MU_COMMAND_RECT, node->cmd_size);
+    memcpy(dst, src, node->cmd_size);
+
+    *current_layout(ctx) = node->layout_out;
+    ctx->last_rect = node->last_rect;
+    node->cached = store_span(tree, node, src, node->cmd_size);
+    tree->reused++;
+}
+
+static void record_leaf(UiTree *tree, mu_Context *ctx, UiNode *node) {
+    const int depth = ctx->layout_stack.idx;
+    const int start = ctx->command_list.idx;
+    node->layout_in = *current_layout(ctx);
+    node->clip = mu_get_clip_rect(ctx);
+
+    node->draw(ctx, node->user);
+
+    const char *span = ctx->command_list.items + start;
+    const int size = ctx->command_list.idx - start;
+    node->dirty = 0;
+    node->cached = 0;
+    tree->rebuilt++;
+
+    // Unbalanced layout or root containers inside a leaf can't be spliced back in later
+    if (ctx->layout_stack.idx != depth || span_has_jump(span, size)) { return; }
+
+    node->layout_out = *current_layout(ctx);
+    node->last_rect = ctx->last_rect;
+
+    const mu_Layout *in = &node->layout_in;
+    const mu_Layout *out = &node->layout_out;
+    const int top = in->body.y + mu_min(in->position.y, in->next_row);
+    const int bottom = out->body.y + out->next_row;
+    node->bounds = mu_rect(in->body.x, top, in->body.w, bottom - top);
+
+    node->cached = store_span(tree, node, span, size);
+}
+
+static int can_reuse(mu_Context *ctx, const UiNode *node, const unsigned dirty) {
+    if (!node->cached || node->dirty || (node->deps & dirty)) { return 0; }
+    if (!rects_equal(node->clip, mu_get_clip_rect(ctx))) { return 0; }
+    if (memcmp(&node->layout_in, current_layout(ctx), sizeof(mu_Layout)) != 0) { return 0; }
+    return !needs_input(ctx, node);
+}
+
+static void emit_node(UiTree *tree, mu_Context *ctx, const int id, const unsigned dirty) {
+    UiNode *node = &tree->nodes[id];
+
+    if (node->first_child >= 0) {
+        if (node->draw) { node->draw(ctx, node->user); }
+        for (int child = node->first_child; child >= 0; child = tree->nodes[child].next_sibling) {
+            emit_node(tree, ctx, child, dirty | *tree->dirty);
+        }
+        if (node->end) { node->end(ctx, node->user); }
+        node->dirty = 0;
+        return;
+    }
+
+    if (!tree->retained) {
+        node->draw(ctx, node->user);
+        return;
+    }
+
+    if (can_reuse(ctx, node, dirty | *tree->dirty)) {
+        replay_leaf(tree, ctx, node);
+    } else {
+        record_leaf(tree, ctx, node);
+    }
+}
+
+void ui_tree_emit(UiTree *tree, mu_Context *ctx) {
+    // Bits raised while emitting (e.g. a slider changing state) stay pending for the next frame
+    const unsigned dirty = *tree->dirty;
+    *tree->dirty = 0;
+
+    tree->cache_idx = 0;
+    tree->rebuilt = 0;
+    tree->reused = 0;
+
+    for (int id = 0; id < tree->count; id++) {
+        if (tree->nodes[id].parent < 0) {
+            emit_node(tree, ctx, id, dirty);
+        }
+    }
+
+    tree->front = !tree->front;
+}
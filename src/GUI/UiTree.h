@@ -0,0 +1,60 @@
+#ifndef UI_TREE_H
+#define UI_TREE_H
+
+#include "microui.h"
+
+#define UI_TREE_MAX_NODES 64
+#define UI_TREE_CACHE_SIZE (MU_COMMANDLIST_SIZE / 2)
+
+enum {
+    UI_NODE_INTERACTIVE = (1 << 0)
+};
+
+typedef void (*UiNodeFn)(mu_Context *ctx, void *user);
+
+typedef struct {
+    UiNodeFn draw;
+    UiNodeFn end;
+    void *user;
+    unsigned deps;
+    int flags;
+    int parent;
+    int first_child;
+    int last_child;
+    int next_sibling;
+    int dirty;
+
+    // Cached command span, valid while the layout and clip it started from are unchanged
+    int cached;
+    mu_Layout layout_in;
+    mu_Layout layout_out;
+    mu_Rect clip;
+    mu_Rect last_rect;
+    mu_Rect bounds;
+    int cmd_offset;
+    int cmd_size;
+} UiNode;
+
+typedef struct {
+    UiNode nodes[UI_TREE_MAX_NODES];
+    int count;
+    int retained;
+    unsigned *dirty;
+
+    char cache[2][UI_TREE_CACHE_SIZE];
+    int cache_idx;
+    int front;
+
+    int rebuilt;
+    int reused;
+} UiTree;
+
+void ui_tree_init(UiTree *tree, unsigned *dirty);
+
+int ui_tree_add(UiTree *tree, int parent, UiNodeFn draw, UiNodeFn end, void *user, unsigned deps, int flags);
+
+void ui_tree_mark_dirty(UiTree *tree, int node);
+
+void ui_tree_emit(UiTree *tree, mu_Context *ctx);
+
+#endif
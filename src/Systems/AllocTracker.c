@@ -0,0 +1,141 @@
+#include "AllocTracker.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+static const char *tag_names[ALLOC_TAG_COUNT] = {
+    [ALLOC_SDL] = "SDL",
+    [ALLOC_UI] = "UI",
+    [ALLOC_RENDER] = "render",
+    [ALLOC_TRACE] = "trace",
+    [ALLOC_REMOTE] = "remote",
+    [ALLOC_LOG] = "log",
+};
+
+static SDL_malloc_func real_malloc;
+static SDL_calloc_func real_calloc;
+static SDL_realloc_func real_realloc;
+static SDL_free_func real_free;
+
+// Counts since the last frame boundary; any thread may allocate
+static SDL_atomic_t frame_allocs[ALLOC_TAG_COUNT];
+static SDL_atomic_t frame_bytes[ALLOC_TAG_COUNT];
+static SDL_atomic_t guarded;
+static SDL_atomic_t armed;
+static int trapping;
+
+// Frame totals, only touched by the thread calling alloc_tracker_end_frame
+static long total_allocs[ALLOC_TAG_COUNT];
+static long total_bytes[ALLOC_TAG_COUNT];
+static int frames;
+static int max_frame_allocs;
+
+static THREAD_LOCAL const char *current_region;
+
+static void record(const AllocTag tag, const size_t size) {
+    SDL_AtomicAdd(&frame_allocs[tag], 1);
+    SDL_AtomicAdd(&frame_bytes[tag], (int) size);
+    if (current_region == NULL || !SDL_AtomicGet(&armed)) { return; }
+
+    SDL_AtomicAdd(&guarded, 1);
+    if (trapping) {
+        fprintf(stderr, "Allocation of %zu bytes (%s) inside %s\n", size, tag_names[tag], current_region);
+        SDL_TriggerBreakpoint();
+    }
+}
+
+static void *SDLCALL hook_malloc(const size_t size) {
+    record(ALLOC_SDL, size);
+    return real_malloc(size);
+}
+
+static void *SDLCALL hook_calloc(const size_t count, const size_t size) {
+    record(ALLOC_SDL, count * size);
+    return real_calloc(count, size);
+}
+
+static void *SDLCALL hook_realloc(void *ptr, const size_t size) {
+    record(ALLOC_SDL, size);
+    return real_realloc(ptr, size);
+}
+
+static void SDLCALL hook_free(void *ptr) {
+    real_free(ptr);
+}
+
+int alloc_tracker_install(void) {
+    SDL_GetMemoryFunctions(&real_malloc, &real_calloc, &real_realloc, &real_free);
+    if (SDL_SetMemoryFunctions(hook_malloc, hook_calloc, hook_realloc, hook_free) != 0) {
+        fprintf(stderr, "Failed to install the allocation tracker: %s\n", SDL_GetError());
+        return -1;
+    }
+    return 0;
+}
+
+void *tracked_malloc(const AllocTag tag, const size_t size) {
+    record(tag, size);
+    return malloc(size);
+}
+
+void *tracked_calloc(const AllocTag tag, const size_t count, const size_t size) {
+    record(tag, count * size);
+    return calloc(count, size);
+}
+
+void *tracked_realloc(const AllocTag tag, void *ptr, const size_t size) {
+    record(tag, size);
+    return realloc(ptr, size);
+}
+
+void tracked_free(void *ptr) {
+    free(ptr);
+}
+
+const char *alloc_tracker_enter(const char *region) {
+    const char *previous = current_region;
+    current_region = region;
+    return previous;
+}
+
+void alloc_tracker_leave(const char *previous) {
+    current_region = previous;
+}
+
+void alloc_tracker_arm(const int trap) {
+    trapping = trap;
+    SDL_AtomicSet(&armed, 1);
+}
+
+int alloc_tracker_end_frame(void) {
+    int count = 0;
+    for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+        const int allocs = SDL_AtomicSet(&frame_allocs[i], 0);
+        total_allocs[i] += allocs;
+        total_bytes[i] += SDL_AtomicSet(&frame_bytes[i], 0);
+        count += allocs;
+    }
+    if (SDL_AtomicGet(&armed) && count > max_frame_allocs) {
+        max_frame_allocs = count;
+    }
+    frames++;
+    return count;
+}
+
+int alloc_tracker_guarded_count(void) {
+    return SDL_AtomicGet(&guarded);
+}
+
+void alloc_tracker_report(void) {
+    printf("Allocations over %d frames:\n", frames);
+    for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+        printf("  %-8s %8ld allocs %12ld bytes\n", tag_names[i], total_allocs[i], total_bytes[i]);
+    }
+    printf("  most in one armed frame: %d, inside guarded regions: %d\n", max_frame_allocs,
+           SDL_AtomicGet(&guarded));
+}
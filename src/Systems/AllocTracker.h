@@ -0,0 +1,45 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <stddef.h>
+
+typedef enum {
+    ALLOC_SDL,
+    ALLOC_UI,
+    ALLOC_RENDER,
+    ALLOC_TRACE,
+    ALLOC_REMOTE,
+    ALLOC_LOG,
+    ALLOC_TAG_COUNT
+} AllocTag;
+
+// Routes SDL's allocator through the tracker. Call before SDL_Init so nothing SDL
+// allocates goes uncounted.
+int alloc_tracker_install(void);
+
+// Our own allocations, counted under their subsystem
+void *tracked_malloc(AllocTag tag, size_t size);
+
+void *tracked_calloc(AllocTag tag, size_t count, size_t size);
+
+void *tracked_realloc(AllocTag tag, void *ptr, size_t size);
+
+void tracked_free(void *ptr);
+
+// Regions that must not allocate in steady state, per thread. enter returns the enclosing
+// region for leave to restore. Allocations inside a region only count once armed, and
+// trap into the debugger when trapping is on.
+const char *alloc_tracker_enter(const char *region);
+
+void alloc_tracker_leave(const char *previous);
+
+void alloc_tracker_arm(int trap);
+
+// Folds the allocations since the previous call into the totals and returns their count
+int alloc_tracker_end_frame(void);
+
+int alloc_tracker_guarded_count(void);
+
+void alloc_tracker_report(void);
+
+#endif
@@ -0,0 +1,81 @@
+#include "FrameScheduler.h"
+#include "Profiler.h"
+#include "src/Constants.h"
+
+static int minimized;
+static int hidden;
+static int focused;
+static int background_work;
+
+void frame_scheduler_init(SDL_Window *window) {
+    const Uint32 flags = SDL_GetWindowFlags(window);
+    minimized = (flags & SDL_WINDOW_MINIMIZED) != 0;
+    hidden = (flags & SDL_WINDOW_HIDDEN) != 0;
+    focused = (flags & SDL_WINDOW_INPUT_FOCUS) != 0;
+}
+
+void frame_scheduler_handle_event(const SDL_Event *e) {
+    if (e->type != SDL_WINDOWEVENT) { return; }
+
+    switch (e->window.event) {
+        case SDL_WINDOWEVENT_MINIMIZED:
+            minimized = 1;
+            break;
+        case SDL_WINDOWEVENT_RESTORED:
+        case SDL_WINDOWEVENT_MAXIMIZED:
+            minimized = 0;
+            break;
+        case SDL_WINDOWEVENT_HIDDEN:
+            hidden = 1;
+            break;
+        case SDL_WINDOWEVENT_SHOWN:
+            hidden = 0;
+            break;
+        case SDL_WINDOWEVENT_EXPOSED:
+            // Something of the window is on screen, whatever came before
+            minimized = hidden = 0;
+            break;
+        case SDL_WINDOWEVENT_FOCUS_GAINED:
+            focused = 1;
+            break;
+        case SDL_WINDOWEVENT_FOCUS_LOST:
+            focused = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+void frame_scheduler_set_background_work(const int on) {
+    background_work = on;
+}
+
+int frame_scheduler_visible(void) {
+    return !minimized && !hidden;
+}
+
+void frame_scheduler_wait(void) {
+    if (!frame_scheduler_visible()) {
+        // Blocks in the event loop until the restore event wakes it, or the next drain is due
+        const Uint64 start = SDL_GetTicks64();
+        if (background_work) {
+            SDL_WaitEventTimeout(NULL, HIDDEN_DRAIN_INTERVAL_MS);
+        } else {
+            SDL_WaitEvent(NULL);
+        }
+        profiler_count(PROFILER_HIDDEN_WAITS, 1);
+        profiler_count(PROFILER_HIDDEN_MS, (long) (SDL_GetTicks64() - start));
+        return;
+    }
+
+    if (!focused) {
+        // Input still gets a frame right away, but never faster than the focused rate
+        profiler_count(PROFILER_FRAMES_UNFOCUSED, 1);
+        if (SDL_WaitEventTimeout(NULL, UNFOCUSED_FRAME_DELAY_MS)) {
+            SDL_Delay(FRAME_DELAY_MS);
+        }
+        return;
+    }
+
+    SDL_Delay(FRAME_DELAY_MS);
+}
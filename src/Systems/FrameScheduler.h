@@ -0,0 +1,25 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <SDL2/SDL.h>
+
+// Paces the main loop by what the window can show: the normal frame rate while focused,
+// UNFOCUSED_FRAME_DELAY_MS between frames while in the background, and no frames at all
+// while minimized or hidden.
+void frame_scheduler_init(SDL_Window *window);
+
+// Tracks visibility and focus; call for every event
+void frame_scheduler_handle_event(const SDL_Event *e);
+
+// Whether the loop has work besides drawing, such as an open ingest source. While it does,
+// hidden waits still end every HIDDEN_DRAIN_INTERVAL_MS so that work keeps up.
+void frame_scheduler_set_background_work(int on);
+
+// 0 while nothing drawn would reach the screen
+int frame_scheduler_visible(void);
+
+// Sleeps until the next frame is due. Background and hidden waits end as soon as an event
+// arrives, so input and restores are handled without delay.
+void frame_scheduler_wait(void);
+
+#endif
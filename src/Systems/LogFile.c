@@ -0,0 +1,255 @@
+#include "LogFile.h"
+#include "src/Constants.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define LOG_QUEUE_SIZE (256 * 1024)
+#define LOG_QUEUE_MASK (LOG_QUEUE_SIZE - 1)
+#define LOG_PATH_SIZE 512
+#define LOG_BATCH_SIZE (64 * 1024)
+
+#ifdef _WIN32
+
+int log_file_start(const char *path) {
+    fprintf(stderr, "Log files are not supported on this platform\n");
+    return -1;
+}
+
+int log_file_push(const LogRecord *record) {
+    return -1;
+}
+
+void log_file_stop(void) {}
+
+void log_file_report(void) {}
+
+#else
+
+#ifdef __APPLE__
+#define SYNC_DATA(fd) fsync(fd)
+#else
+#define SYNC_DATA(fd) fdatasync(fd)
+#endif
+
+/*
+ * The queue is a byte ring of binary records, which may wrap around its end. head and
+ * tail count bytes ever queued and ever taken; producers advance head under a spinlock,
+ * the writer thread advances tail once it has formatted a record into its batch. A full
+ * queue drops the record, so a writer stuck in a slow sync never holds up the caller.
+ */
+static char queue[LOG_QUEUE_SIZE];
+static char batch[LOG_BATCH_SIZE];
+static int batch_len;
+static SDL_atomic_t queue_head;
+static SDL_atomic_t queue_tail;
+static SDL_SpinLock producer_lock;
+static SDL_atomic_t running;
+static SDL_sem *wake;
+static SDL_Thread *thread;
+
+static char path_base[LOG_PATH_SIZE];
+static int fd = -1;
+static long file_bytes;
+static Uint64 file_opened_ms;
+static Uint64 last_sync_ms;
+static int unsynced;
+
+// Writer statistics, read once the thread has stopped
+static long bytes_written;
+static long write_calls;
+static long sync_calls;
+static long rotations;
+static Uint64 longest_sync_ms;
+static SDL_atomic_t dropped;
+
+static int open_log(void) {
+    fd = open(path_base, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open log file %s: %s\n", path_base, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    file_bytes = fstat(fd, &st) == 0 ? (long) st.st_size : 0;
+    file_opened_ms = SDL_GetTicks64();
+    return 0;
+}
+
+static void sync_log(void) {
+    const Uint64 start = SDL_GetTicks64();
+    SYNC_DATA(fd);
+    last_sync_ms = SDL_GetTicks64();
+    if (last_sync_ms - start > longest_sync_ms) {
+        longest_sync_ms = last_sync_ms - start;
+    }
+    unsynced = 0;
+    sync_calls++;
+}
+
+// Shifts path.N-1 to path.N down to path to path.1, dropping the oldest, and reopens
+static void rotate_log(void) {
+    if (unsynced) { sync_log(); }
+    close(fd);
+    fd = -1;
+
+    char from[LOG_PATH_SIZE + 8], to[LOG_PATH_SIZE + 8];
+    for (int i = LOG_KEEP_FILES - 1; i > 0; i--) {
+        snprintf(from, sizeof(from), "%s.%d", path_base, i);
+        snprintf(to, sizeof(to), "%s.%d", path_base, i + 1);
+        rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%s.1", path_base);
+    rename(path_base, to);
+    rotations++;
+    open_log();
+}
+
+static void write_batch(void) {
+    for (int done = 0; done < batch_len;) {
+        const ssize_t n = fd >= 0 ? write(fd, batch + done, batch_len - done) : -1;
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) {
+            // Nothing can be written; drop the batch rather than let the queue back up
+            fprintf(stderr, "Failed to write log file %s: %s\n", path_base, strerror(errno));
+            break;
+        }
+        done += (int) n;
+        bytes_written += n;
+        file_bytes += n;
+        write_calls++;
+        unsynced = 1;
+    }
+    batch_len = 0;
+}
+
+static void copy_out(char *dst, const unsigned from, const unsigned size) {
+    const unsigned start = from & LOG_QUEUE_MASK;
+    const unsigned first = size < LOG_QUEUE_SIZE - start ? size : LOG_QUEUE_SIZE - start;
+    memcpy(dst, queue + start, first);
+    memcpy(dst + first, queue, size - first);
+}
+
+// Formats every queued record into the batch, writing it out whenever it fills up
+static void flush_queue(void) {
+    const unsigned head = (unsigned) SDL_AtomicGet(&queue_head);
+    unsigned tail = (unsigned) SDL_AtomicGet(&queue_tail);
+
+    LogRecordBuffer buf;
+    while (tail != head) {
+        copy_out(buf.bytes, tail, sizeof(LogRecord));
+        copy_out(buf.bytes, tail, buf.record.size);
+        tail += buf.record.size;
+        SDL_AtomicSet(&queue_tail, (int) tail);
+
+        if (LOG_BATCH_SIZE - batch_len < LOG_LINE_MAX + 1) { write_batch(); }
+        batch_len += log_record_format(&buf.record, batch + batch_len, LOG_LINE_MAX,
+                                       LOG_FORMAT_DATE | LOG_FORMAT_TIME | LOG_FORMAT_LEVEL |
+                                       LOG_FORMAT_CATEGORY);
+        batch[batch_len++] = '\n';
+    }
+    if (batch_len > 0) { write_batch(); }
+}
+
+static int writer_loop(void *data) {
+    int stopping = 0;
+    while (!stopping) {
+        SDL_SemWaitTimeout(wake, LOG_FLUSH_INTERVAL_MS);
+        stopping = !SDL_AtomicGet(&running);
+        flush_queue();
+
+        const Uint64 now = SDL_GetTicks64();
+        if (unsynced && (stopping || now - last_sync_ms >= LOG_SYNC_INTERVAL_MS)) {
+            sync_log();
+        }
+        if (fd >= 0 && file_bytes > 0 && !stopping &&
+            (file_bytes >= LOG_ROTATE_BYTES || now - file_opened_ms >= LOG_ROTATE_SECONDS * 1000ull)) {
+            rotate_log();
+        }
+    }
+    return 0;
+}
+
+int log_file_start(const char *path) {
+    if (strlen(path) >= sizeof(path_base)) {
+        fprintf(stderr, "Log file path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(path_base, path);
+    if (open_log() != 0) { return -1; }
+
+    wake = SDL_CreateSemaphore(0);
+    if (wake == NULL) {
+        close(fd);
+        fd = -1;
+        return -1;
+    }
+    last_sync_ms = SDL_GetTicks64();
+    SDL_AtomicSet(&running, 1);
+
+    thread = SDL_CreateThread(writer_loop, "log writer", NULL);
+    if (thread == NULL) {
+        fprintf(stderr, "Failed to create log writer thread: %s\n", SDL_GetError());
+        SDL_AtomicSet(&running, 0);
+        SDL_DestroySemaphore(wake);
+        close(fd);
+        fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+int log_file_push(const LogRecord *record) {
+    if (!SDL_AtomicGet(&running)) { return -1; }
+
+    const unsigned size = record->size;
+    SDL_AtomicLock(&producer_lock);
+    const unsigned head = (unsigned) SDL_AtomicGet(&queue_head);
+    const unsigned used = head - (unsigned) SDL_AtomicGet(&queue_tail);
+    if (LOG_QUEUE_SIZE - used < size) {
+        SDL_AtomicUnlock(&producer_lock);
+        SDL_AtomicIncRef(&dropped);
+        return -1;
+    }
+
+    const unsigned start = head & LOG_QUEUE_MASK;
+    const unsigned first = size < LOG_QUEUE_SIZE - start ? size : LOG_QUEUE_SIZE - start;
+    memcpy(queue + start, record, first);
+    memcpy(queue, (const char *) record + first, size - first);
+    SDL_AtomicSet(&queue_head, (int) (head + size));
+    SDL_AtomicUnlock(&producer_lock);
+
+    // Only wake the writer early once the queue is half full; otherwise it batches until
+    // the next flush interval
+    if (used < LOG_QUEUE_SIZE / 2 && used + size >= LOG_QUEUE_SIZE / 2) {
+        SDL_SemPost(wake);
+    }
+    return 0;
+}
+
+void log_file_stop(void) {
+    if (thread == NULL) { return; }
+
+    SDL_AtomicSet(&running, 0);
+    SDL_SemPost(wake);
+    SDL_WaitThread(thread, NULL);
+    thread = NULL;
+
+    SDL_DestroySemaphore(wake);
+    if (fd >= 0) { close(fd); }
+    fd = -1;
+}
+
+void log_file_report(void) {
+    printf("Log file: %ld bytes in %ld writes, %ld syncs (longest %llu ms), %ld rotations, %d records dropped\n",
+           bytes_written, write_calls, sync_calls, (unsigned long long) longest_sync_ms, rotations,
+           SDL_AtomicGet(&dropped));
+}
+
+#endif
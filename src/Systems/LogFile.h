@@ -0,0 +1,20 @@
+#ifndef LOG_FILE_H
+#define LOG_FILE_H
+
+#include "LogRecord.h"
+
+// Persistent log sink. Records are copied into a bounded queue and a background thread
+// formats and appends them to the file in batches, syncing every LOG_SYNC_INTERVAL_MS and rotating
+// the file once it grows past LOG_ROTATE_BYTES or gets older than LOG_ROTATE_SECONDS.
+int log_file_start(const char *path);
+
+// Queues one record without ever waiting on the writer, which formats it. Returns -1
+// when it was dropped because the queue is full or no file is open.
+int log_file_push(const LogRecord *record);
+
+// Writes out everything still queued, syncs and closes the file
+void log_file_stop(void);
+
+void log_file_report(void);
+
+#endif
@@ -0,0 +1,434 @@
+#include "LogRecord.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RECORD_ALIGN 8
+#define SPEC_MAX 64
+#define SPEC_MAX_WRITTEN 16
+#define STRING_NULL "(null)"
+// Argument bytes a record can hold, leaving room to pad the last one to RECORD_ALIGN
+#define RECORD_ROOM ((int) (LOG_MAX_RECORD - sizeof(LogRecord)) - RECORD_ALIGN)
+
+typedef enum {
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_DOUBLE,
+    ARG_STRING,
+    ARG_POINTER
+} ArgType;
+
+// min_size is what the arguments take with every string empty
+typedef struct {
+    const char *fmt;
+    uint8_t types[LOG_MAX_ARGS];
+    int arg_count;
+    int min_size;
+} LogFormat;
+
+// One conversion: which of width, precision and value it takes from the arguments
+typedef struct {
+    int width_arg;
+    int precision_arg;
+    int type;
+} Spec;
+
+static const char *level_names[LOG_LEVEL_COUNT] = {
+    [LOG_LEVEL_DEBUG] = "DEBUG",
+    [LOG_LEVEL_INFO] = "INFO ",
+    [LOG_LEVEL_WARN] = "WARN ",
+    [LOG_LEVEL_ERROR] = "ERROR",
+};
+
+static const char *category_names[LOG_CATEGORY_COUNT] = {
+    [LOG_CATEGORY_APP] = "app",
+    [LOG_CATEGORY_UI] = "ui",
+    [LOG_CATEGORY_RENDER] = "render",
+    [LOG_CATEGORY_SYSTEM] = "system",
+    [LOG_CATEGORY_EXTERNAL] = "extern",
+};
+
+// Format 0 is the preformatted-text format every write_log line uses
+static LogFormat formats[LOG_MAX_FORMATS] = {
+    {.fmt = "%s", .types = {ARG_STRING}, .arg_count = 1, .min_size = sizeof(uint16_t)}
+};
+static SDL_atomic_t format_count = {1};
+static SDL_SpinLock format_lock;
+
+static struct timespec base_time;
+static Uint64 base_ticks;
+static Uint64 tick_frequency = 1;
+
+void log_record_init(void) {
+    timespec_get(&base_time, TIME_UTC);
+    base_ticks = SDL_GetPerformanceCounter();
+    tick_frequency = SDL_GetPerformanceFrequency();
+}
+
+// p points just past the '%'. Returns the character after the conversion, with type -1
+// for conversions a record can't capture (%n, long double, wide strings).
+static const char *scan_spec(const char *p, Spec *spec) {
+    spec->width_arg = 0;
+    spec->precision_arg = 0;
+    spec->type = -1;
+
+    while (*p && strchr("-+ #0", *p)) { p++; }
+    if (*p == '*') {
+        spec->width_arg = 1;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') { p++; }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->precision_arg = 1;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') { p++; }
+    }
+
+    int length = ARG_INT;
+    if (*p == 'h') {
+        p += p[1] == 'h' ? 2 : 1;
+    } else if (*p == 'l') {
+        length = p[1] == 'l' ? ARG_LLONG : ARG_LONG;
+        p += p[1] == 'l' ? 2 : 1;
+    } else if (*p == 'z' || *p == 't') {
+        length = ARG_SIZE;
+        p++;
+    } else if (*p == 'L' || *p == 'j') {
+        return *++p ? p + 1 : p;
+    }
+
+    switch (*p) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            spec->type = length;
+            break;
+        case 'c':
+            spec->type = length == ARG_INT ? ARG_INT : -1;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec->type = ARG_DOUBLE;
+            break;
+        case 's':
+            spec->type = length == ARG_INT ? ARG_STRING : -1;
+            break;
+        case 'p':
+            spec->type = ARG_POINTER;
+            break;
+        default:
+            break;
+    }
+    return *p ? p + 1 : p;
+}
+
+// Bytes an argument of type takes in a record, not counting a string's own bytes
+static int arg_size(const int type) {
+    switch (type) {
+        case ARG_INT:
+            return sizeof(int);
+        case ARG_LONG:
+            return sizeof(long);
+        case ARG_LLONG:
+            return sizeof(long long);
+        case ARG_SIZE:
+            return sizeof(size_t);
+        case ARG_DOUBLE:
+            return sizeof(double);
+        case ARG_POINTER:
+            return sizeof(void *);
+        case ARG_STRING:
+            return sizeof(uint16_t);
+        default:
+            return 0;
+    }
+}
+
+// Returns the argument types fmt consumes, or -1 if it can't be recorded
+static int parse_format(const char *fmt, uint8_t *types) {
+    int count = 0;
+    for (const char *p = fmt; *p;) {
+        if (*p++ != '%') { continue; }
+        if (*p == '%') {
+            p++;
+            continue;
+        }
+
+        Spec spec;
+        const char *start = p;
+        p = scan_spec(p, &spec);
+        if (spec.type < 0 || p - start > SPEC_MAX_WRITTEN || count + spec.width_arg + spec.precision_arg + 1 > LOG_MAX_ARGS) { return -1; }
+        if (spec.width_arg) { types[count++] = ARG_INT; }
+        if (spec.precision_arg) { types[count++] = ARG_INT; }
+        types[count++] = (uint8_t) spec.type;
+    }
+    return count;
+}
+
+static int register_format(SDL_atomic_t *format_id, const char *fmt) {
+    uint8_t types[LOG_MAX_ARGS];
+    const int arg_count = parse_format(fmt, types);
+    int min_size = 0;
+    for (int i = 0; i < arg_count; i++) { min_size += arg_size(types[i]); }
+
+    SDL_AtomicLock(&format_lock);
+    int id = SDL_AtomicGet(format_id);
+    if (id == -1) {
+        id = SDL_AtomicGet(&format_count);
+        if (arg_count < 0 || id == LOG_MAX_FORMATS || min_size > RECORD_ROOM) {
+            id = LOG_FORMAT_EAGER;
+        } else {
+            formats[id].fmt = fmt;
+            memcpy(formats[id].types, types, sizeof(types));
+            formats[id].arg_count = arg_count;
+            formats[id].min_size = min_size;
+            SDL_AtomicSet(&format_count, id + 1);
+        }
+        SDL_AtomicSet(format_id, id);
+    }
+    SDL_AtomicUnlock(&format_lock);
+    return id;
+}
+
+const char *log_record_format_string(const int format) {
+    return formats[format > 0 && format < SDL_AtomicGet(&format_count) ? format : 0].fmt;
+}
+
+const char *log_record_category_name(const LogCategory category) {
+    return category < LOG_CATEGORY_COUNT ? category_names[category] : "?";
+}
+
+static void begin_record(LogRecordBuffer *out, const int format, const LogCategory category, const LogLevel level) {
+    out->record.format = (uint16_t) format;
+    out->record.level = (uint8_t) level;
+    out->record.category = (uint8_t) category;
+    out->record.ticks = SDL_GetPerformanceCounter();
+}
+
+static int finish_record(LogRecordBuffer *out, const int size) {
+    const int aligned = (size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+    // Zeroed so equal messages are equal records
+    memset(out->bytes + size, 0, aligned - size);
+    out->record.size = (uint16_t) aligned;
+    return aligned;
+}
+
+// Truncates text to what's left once reserve bytes are kept for the arguments after it
+static int put_string(LogRecordBuffer *out, const int size, const char *text, const int reserve) {
+    if (text == NULL) { text = STRING_NULL; }
+    const int room = SDL_max(LOG_MAX_RECORD - RECORD_ALIGN - size - (int) sizeof(uint16_t) - reserve, 0);
+    const size_t len = strlen(text);
+    const uint16_t stored = (uint16_t) (len < (size_t) room ? len : (size_t) room);
+    memcpy(out->bytes + size, &stored, sizeof(stored));
+    memcpy(out->bytes + size + sizeof(stored), text, stored);
+    return size + (int) sizeof(stored) + stored;
+}
+
+int log_record_encode_text(LogRecordBuffer *out, const LogCategory category, const LogLevel level, const char *text) {
+    begin_record(out, 0, category, level);
+    return finish_record(out, put_string(out, sizeof(LogRecord), text, 0));
+}
+
+int log_record_encode(LogRecordBuffer *out, SDL_atomic_t *format_id, const LogCategory category,
+                      const LogLevel level, const char *fmt, va_list args) {
+    int id = SDL_AtomicGet(format_id);
+    if (id == -1) { id = register_format(format_id, fmt); }
+    if (id == LOG_FORMAT_EAGER) {
+        char text[LOG_LINE_MAX];
+        vsnprintf(text, sizeof(text), fmt, args);
+        return log_record_encode_text(out, category, level, text);
+    }
+
+    begin_record(out, id, category, level);
+    const LogFormat *f = &formats[id];
+    int size = sizeof(LogRecord);
+    int reserve = f->min_size;
+    for (int i = 0; i < f->arg_count; i++) {
+        reserve -= arg_size(f->types[i]);
+        switch (f->types[i]) {
+            case ARG_INT: {
+                const int v = va_arg(args, int);
+                memcpy(out->bytes + size, &v, sizeof(v));
+                size += sizeof(v);
+                break;
+            }
+            case ARG_LONG: {
+                const long v = va_arg(args, long);
+                memcpy(out->bytes + size, &v, sizeof(v));
+                size += sizeof(v);
+                break;
+            }
+            case ARG_LLONG: {
+                const long long v = va_arg(args, long long);
+                memcpy(out->bytes + size, &v, sizeof(v));
+                size += sizeof(v);
+                break;
+            }
+            case ARG_SIZE: {
+                const size_t v = va_arg(args, size_t);
+                memcpy(out->bytes + size, &v, sizeof(v));
+                size += sizeof(v);
+                break;
+            }
+            case ARG_DOUBLE: {
+                const double v = va_arg(args, double);
+                memcpy(out->bytes + size, &v, sizeof(v));
+                size += sizeof(v);
+                break;
+            }
+            case ARG_POINTER: {
+                const void *v = va_arg(args, void *);
+                memcpy(out->bytes + size, &v, sizeof(v));
+                size += sizeof(v);
+                break;
+            }
+            case ARG_STRING:
+                size = put_string(out, size, va_arg(args, const char *), reserve);
+                break;
+            default:
+                break;
+        }
+    }
+    return finish_record(out, size);
+}
+
+static int read_int(const unsigned char **arg) {
+    int v;
+    memcpy(&v, *arg, sizeof(v));
+    *arg += sizeof(v);
+    return v;
+}
+
+// Formats one conversion; spec runs from its '%' to end and any '*' takes the next int
+static int format_spec(char *out, const int size, const char *spec, const char *end, const int type,
+                       const unsigned char **arg) {
+    char text[SPEC_MAX];
+    int len = 0;
+    for (const char *p = spec; p < end; p++) {
+        if (*p == '*') {
+            len += snprintf(text + len, SPEC_MAX - len, "%d", read_int(arg));
+        } else {
+            text[len++] = *p;
+        }
+    }
+    text[len] = '\0';
+
+    switch (type) {
+        case ARG_INT:
+            return snprintf(out, size, text, read_int(arg));
+        case ARG_LONG: {
+            long v;
+            memcpy(&v, *arg, sizeof(v));
+            *arg += sizeof(v);
+            return snprintf(out, size, text, v);
+        }
+        case ARG_LLONG: {
+            long long v;
+            memcpy(&v, *arg, sizeof(v));
+            *arg += sizeof(v);
+            return snprintf(out, size, text, v);
+        }
+        case ARG_SIZE: {
+            size_t v;
+            memcpy(&v, *arg, sizeof(v));
+            *arg += sizeof(v);
+            return snprintf(out, size, text, v);
+        }
+        case ARG_DOUBLE: {
+            double v;
+            memcpy(&v, *arg, sizeof(v));
+            *arg += sizeof(v);
+            return snprintf(out, size, text, v);
+        }
+        case ARG_POINTER: {
+            void *v;
+            memcpy(&v, *arg, sizeof(v));
+            *arg += sizeof(v);
+            return snprintf(out, size, text, v);
+        }
+        case ARG_STRING: {
+            uint16_t stored;
+            memcpy(&stored, *arg, sizeof(stored));
+            const char *str = (const char *) *arg + sizeof(stored);
+            *arg += sizeof(stored) + stored;
+
+            // Recorded strings aren't NUL-terminated, so the precision is capped at their
+            // length and passed as an argument; flags and width stay as written
+            int precision = stored;
+            char *dot = strchr(text, '.');
+            if (dot != NULL) {
+                const int requested = atoi(dot + 1);
+                if (requested < precision) { precision = requested; }
+            } else {
+                dot = text + len - 1;
+            }
+            strcpy(dot, ".*s");
+            return snprintf(out, size, text, precision, str);
+        }
+        default:
+            return 0;
+    }
+}
+
+static int format_prefix(const LogRecord *record, char *out, const int size, const int flags) {
+    int len = 0;
+    if (flags & (LOG_FORMAT_TIME | LOG_FORMAT_DATE)) {
+        const double elapsed = (double) (record->ticks - base_ticks) / (double) tick_frequency;
+        const long long ms = (long long) base_time.tv_sec * 1000 + base_time.tv_nsec / 1000000 +
+                             (long long) (elapsed * 1000.0);
+        const time_t seconds = (time_t) (ms / 1000);
+
+        struct tm tm;
+#ifdef _WIN32
+        localtime_s(&tm, &seconds);
+#else
+        localtime_r(&seconds, &tm);
+#endif
+        if (flags & LOG_FORMAT_DATE) {
+            len += snprintf(out + len, size - len, "%04d-%02d-%02d ", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+        }
+        if (len >= size) { return len; }
+        len += snprintf(out + len, size - len, "%02d:%02d:%02d.%03d ", tm.tm_hour, tm.tm_min, tm.tm_sec,
+                        (int) (ms % 1000));
+    }
+    if ((flags & LOG_FORMAT_LEVEL) && len < size) {
+        const char *level = record->level < LOG_LEVEL_COUNT ? level_names[record->level] : "?    ";
+        len += snprintf(out + len, size - len, "%s ", level);
+    }
+    if ((flags & LOG_FORMAT_CATEGORY) && len < size) {
+        len += snprintf(out + len, size - len, "%-6s ", log_record_category_name(record->category));
+    }
+    return len;
+}
+
+int log_record_format(const LogRecord *record, char *out, const int size, const int flags) {
+    if (size <= 0) { return 0; }
+    int len = format_prefix(record, out, size, flags);
+    if (len >= size) { return size - 1; }
+
+    const LogFormat *f = &formats[record->format < SDL_AtomicGet(&format_count) ? record->format : 0];
+    const unsigned char *arg = (const unsigned char *) (record + 1);
+    for (const char *p = f->fmt; *p && len < size - 1;) {
+        if (*p != '%') {
+            out[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        Spec spec;
+        const char *end = scan_spec(p + 1, &spec);
+        const int n = format_spec(out + len, size - len, p, end, spec.type, &arg);
+        len += n < size - len ? n : size - len - 1;
+        p = end;
+    }
+    out[len] = '\0';
+    return len;
+}
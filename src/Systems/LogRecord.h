@@ -0,0 +1,84 @@
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include <SDL2/SDL_atomic.h>
+#include <stdarg.h>
+#include <stdint.h>
+
+#define LOG_MAX_ARGS 8
+#define LOG_MAX_FORMATS 256
+#define LOG_MAX_RECORD 512
+#define LOG_LINE_MAX 512
+
+// Marks a call site whose format records can't hold; its lines are formatted eagerly
+#define LOG_FORMAT_EAGER (-2)
+
+typedef enum {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_COUNT
+} LogLevel;
+
+// Where a line comes from
+typedef enum {
+    LOG_CATEGORY_APP,
+    LOG_CATEGORY_UI,
+    LOG_CATEGORY_RENDER,
+    LOG_CATEGORY_SYSTEM,
+    LOG_CATEGORY_EXTERNAL,
+    LOG_CATEGORY_COUNT
+} LogCategory;
+
+// What log_record_format puts in front of the message
+enum {
+    LOG_FORMAT_TIME = (1 << 0),
+    LOG_FORMAT_DATE = (1 << 1),
+    LOG_FORMAT_LEVEL = (1 << 2),
+    LOG_FORMAT_CATEGORY = (1 << 3)
+};
+
+/*
+ * A record is this header followed by the raw arguments in format order: integers,
+ * pointers and doubles as their native bytes, strings as a uint16 length and the bytes.
+ * size covers both and is a multiple of 8, so records stay aligned when packed back to
+ * back. Records hold no pointers into the caller, so they can be copied between queues
+ * and formatted later on any thread.
+ */
+typedef struct {
+    uint16_t size;
+    uint16_t format;
+    uint8_t level;
+    uint8_t category;
+    uint8_t reserved[2];
+    uint64_t ticks;
+} LogRecord;
+
+typedef union {
+    LogRecord record;
+    char bytes[LOG_MAX_RECORD];
+} LogRecordBuffer;
+
+// Anchors record timestamps to the wall clock; call once before logging
+void log_record_init(void);
+
+// Registers fmt the first time a call site is seen and keeps its id in *format_id, which
+// starts out as -1. Returns the record size.
+int log_record_encode(LogRecordBuffer *out, SDL_atomic_t *format_id, LogCategory category, LogLevel level,
+                      const char *fmt, va_list args);
+
+// A record holding one preformatted string
+int log_record_encode_text(LogRecordBuffer *out, LogCategory category, LogLevel level, const char *text);
+
+// The fmt a format id was registered with
+const char *log_record_format_string(int format);
+
+const char *log_record_category_name(LogCategory category);
+
+// Formats the record as "YYYY-MM-DD HH:MM:SS.mmm LEVEL category message" with the parts
+// selected by flags; level and category are padded to a fixed width. Returns the length
+// written, always NUL-terminated.
+int log_record_format(const LogRecord *record, char *out, int size, int flags);
+
+#endif
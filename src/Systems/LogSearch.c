@@ -0,0 +1,531 @@
+#include "LogSearch.h"
+#include "AllocTracker.h"
+#include "Logger.h"
+#include "MappedLog.h"
+#include "src/Constants.h"
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define BUCKET_SHIFT 16
+#define BUCKET_COUNT (1 << BUCKET_SHIFT)
+#define BLOCK_SHIFT 5
+#define BLOCK_LINES (1 << BLOCK_SHIFT)
+#define POSTING_BYTES 44
+#define VARINT_MAX 5
+#define SLAB_CHUNKS 16384
+#define RESULT_CHUNK_SHIFT 16
+#define RESULT_CHUNK_SIZE (1 << RESULT_CHUNK_SHIFT)
+#define RESULT_CHUNK_MASK (RESULT_CHUNK_SIZE - 1)
+#define RESULT_MAX_CHUNKS 1024
+#define INDEX_BATCH_LINES 65536
+#define SCAN_LINES 1024
+
+/*
+ * The index maps each trigram of a mapped line, case-folded and hashed into BUCKET_COUNT
+ * buckets, to the ascending list of BLOCK_LINES-line blocks it occurs in. A query only
+ * has to look at the blocks in which every one of its trigrams occurs, and then checks
+ * each line of those blocks for the actual text; hash collisions and trigrams that
+ * occur on different lines only cost extra checks.
+ *
+ * Lists are chains of fixed-size chunks carved out of slabs, all owned by the worker
+ * thread, so they need no locking. A chunk stores its first block and then the gap to
+ * each following one as a varint, so common trigrams cost about a byte per block. Lines
+ * past LOG_SEARCH_MAX_INDEX worth of index are still matched, just by scanning. The
+ * in-memory log holds few enough lines that scanning it is cheaper than indexing it.
+ */
+typedef struct PostingChunk {
+    struct PostingChunk *next;
+    uint32_t first;
+    uint32_t last;
+    uint32_t used;
+    uint8_t gaps[POSTING_BYTES];
+} PostingChunk;
+
+typedef struct Slab {
+    struct Slab *next;
+    PostingChunk chunks[SLAB_CHUNKS];
+} Slab;
+
+typedef struct {
+    PostingChunk *head;
+    PostingChunk *tail;
+    uint32_t last; // Newest block + 1, or 0 while empty
+} Posting;
+
+typedef struct {
+    const PostingChunk *chunk;
+    uint32_t pos;
+    uint32_t block;
+} PostingCursor;
+
+static unsigned char fold[256];
+
+// Worker state
+static Posting postings[BUCKET_COUNT];
+static Slab *slabs;
+static int slab_used = SLAB_CHUNKS;
+static long index_bytes;
+static int source_mapped;
+static int source_generation;
+static long next_line;     // Every line before this one has been seen
+static long index_end;     // Lines before this one are indexed, the rest only scanned
+static long tail_checked;  // Unterminated last line already matched, and its length
+static int tail_checked_len;
+static unsigned char query[LOG_SEARCH_QUERY_MAX];
+static int query_len;
+
+// Shared with the UI thread
+static char query_text[LOG_SEARCH_QUERY_MAX];
+static SDL_SpinLock query_lock;
+static SDL_atomic_t query_generation;
+static long *result_chunks[RESULT_MAX_CHUNKS];
+static SDL_atomic_t result_count;
+static SDL_atomic_t busy;
+static SDL_atomic_t updated;
+static SDL_atomic_t running;
+static SDL_sem *wake;
+static SDL_Thread *thread;
+
+// Statistics, read once the worker has stopped
+static long peak_index_bytes;
+static long queries_run;
+static Uint64 longest_query_us;
+static long results_dropped;
+
+static uint32_t trigram_bucket(const uint32_t trigram) {
+    return (trigram * 2654435761u) >> (32 - BUCKET_SHIFT);
+}
+
+static PostingChunk *alloc_chunk(const uint32_t block) {
+    if (slab_used == SLAB_CHUNKS) {
+        if (index_bytes + (long) sizeof(Slab) > LOG_SEARCH_MAX_INDEX) { return NULL; }
+        Slab *slab = tracked_malloc(ALLOC_LOG, sizeof(Slab));
+        if (slab == NULL) { return NULL; }
+        slab->next = slabs;
+        slabs = slab;
+        slab_used = 0;
+        index_bytes += sizeof(Slab);
+        peak_index_bytes = SDL_max(peak_index_bytes, index_bytes);
+    }
+    PostingChunk *chunk = &slabs->chunks[slab_used++];
+    chunk->next = NULL;
+    chunk->first = block;
+    chunk->last = block;
+    chunk->used = 0;
+    return chunk;
+}
+
+static int add_posting(const uint32_t bucket, const uint32_t block) {
+    Posting *p = &postings[bucket];
+    if (p->last == block + 1) { return 0; }
+
+    if (p->tail == NULL || p->tail->used + VARINT_MAX > POSTING_BYTES) {
+        PostingChunk *chunk = alloc_chunk(block);
+        if (chunk == NULL) { return -1; }
+        if (p->tail != NULL) {
+            p->tail->next = chunk;
+        } else {
+            p->head = chunk;
+        }
+        p->tail = chunk;
+    } else {
+        PostingChunk *chunk = p->tail;
+        uint32_t gap = block - chunk->last;
+        for (; gap >= 0x80; gap >>= 7) { chunk->gaps[chunk->used++] = (uint8_t) (gap | 0x80); }
+        chunk->gaps[chunk->used++] = (uint8_t) gap;
+        chunk->last = block;
+    }
+    p->last = block + 1;
+    return 0;
+}
+
+static int index_line(const long line, const char *text, const int len) {
+    const uint32_t block = (uint32_t) (line >> BLOCK_SHIFT);
+    uint32_t trigram = 0;
+    for (int i = 0; i < len; i++) {
+        trigram = (trigram << 8 | fold[(unsigned char) text[i]]) & 0xFFFFFF;
+        if (i >= 2 && add_posting(trigram_bucket(trigram), block) != 0) { return -1; }
+    }
+    return 0;
+}
+
+static void reset_index(void) {
+    while (slabs != NULL) {
+        Slab *next = slabs->next;
+        tracked_free(slabs);
+        slabs = next;
+    }
+    slab_used = SLAB_CHUNKS;
+    index_bytes = 0;
+    memset(postings, 0, sizeof(postings));
+}
+
+static PostingCursor cursor_begin(const PostingChunk *chunk) {
+    return (PostingCursor){chunk, 0, chunk != NULL ? chunk->first : 0};
+}
+
+// Moves the cursor to its first block at or after block; returns 0 once the list runs out
+static int cursor_seek(PostingCursor *c, const uint32_t block) {
+    while (c->chunk != NULL && c->chunk->last < block) { *c = cursor_begin(c->chunk->next); }
+    if (c->chunk == NULL) { return 0; }
+
+    while (c->block < block) {
+        uint32_t gap = 0;
+        for (int shift = 0;; shift += 7) {
+            const uint8_t byte = c->chunk->gaps[c->pos++];
+            gap |= (uint32_t) (byte & 0x7F) << shift;
+            if (byte < 0x80) { break; }
+        }
+        c->block += gap;
+    }
+    return 1;
+}
+
+static int query_at(const char *text) {
+    int i = 0;
+    while (i < query_len && fold[(unsigned char) text[i]] == query[i]) { i++; }
+    return i == query_len;
+}
+
+// First occurrence of the query in text, ignoring ASCII case
+static const char *find_query(const char *text, const size_t len) {
+    if (len < (size_t) query_len) { return NULL; }
+    const size_t last = len - query_len;
+    const int end = query_len - 1;
+    size_t i = 0;
+
+#ifdef __SSE2__
+    // Candidates are where both the first and the last byte of the query line up, 16
+    // positions at a time. Setting bit 5 folds letters, and only letters, to lower case.
+    const __m128i first = _mm_set1_epi8((char) query[0]);
+    const __m128i final = _mm_set1_epi8((char) query[end]);
+    const __m128i first_fold = _mm_set1_epi8(query[0] >= 'a' && query[0] <= 'z' ? 0x20 : 0);
+    const __m128i final_fold = _mm_set1_epi8(query[end] >= 'a' && query[end] <= 'z' ? 0x20 : 0);
+    for (; i + 16 <= last + 1; i += 16) {
+        const __m128i a = _mm_or_si128(_mm_loadu_si128((const __m128i *) (text + i)), first_fold);
+        const __m128i b = _mm_or_si128(_mm_loadu_si128((const __m128i *) (text + i + end)), final_fold);
+        unsigned mask = (unsigned) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first),
+                                                                   _mm_cmpeq_epi8(b, final)));
+        while (mask) {
+            const size_t pos = i + __builtin_ctz(mask);
+            if (query_at(text + pos)) { return text + pos; }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i <= last; i++) {
+        if (query_at(text + i)) { return text + i; }
+    }
+    return NULL;
+}
+
+static int line_matches(const char *text, const int len) {
+    return find_query(text, len) != NULL;
+}
+
+static long result_at(const int index) {
+    return result_chunks[index >> RESULT_CHUNK_SHIFT][index & RESULT_CHUNK_MASK];
+}
+
+static void clear_results(void) {
+    SDL_AtomicSet(&result_count, 0);
+    SDL_AtomicSet(&updated, 1);
+}
+
+// Results stay ascending: a line matched both by a query and by the scan of newly seen
+// lines is only kept once
+static void push_result(const long line) {
+    const int count = SDL_AtomicGet(&result_count);
+    if (count > 0 && result_at(count - 1) >= line) { return; }
+
+    const int chunk = count >> RESULT_CHUNK_SHIFT;
+    if (chunk >= RESULT_MAX_CHUNKS) {
+        results_dropped++;
+        return;
+    }
+    if (result_chunks[chunk] == NULL) {
+        result_chunks[chunk] = tracked_malloc(ALLOC_LOG, RESULT_CHUNK_SIZE * sizeof(long));
+        if (result_chunks[chunk] == NULL) {
+            results_dropped++;
+            return;
+        }
+    }
+    result_chunks[chunk][count & RESULT_CHUNK_MASK] = line;
+    SDL_AtomicSet(&result_count, count + 1);
+    SDL_AtomicSet(&updated, 1);
+}
+
+// Fetches a line from whichever source is current; scratch holds in-memory lines
+static const char *source_line(const long line, char *scratch, int *len) {
+    if (source_mapped) { return mapped_log_line(line, len); }
+    *len = logger_format_line_id(line, scratch, LOG_LINE_MAX, 0);
+    return *len >= 0 ? scratch : NULL;
+}
+
+static void match_line(const long line, char *scratch) {
+    int len;
+    const char *text = source_line(line, scratch, &len);
+    if (text != NULL && line_matches(text, len)) { push_result(line); }
+}
+
+// Mapped lines lie back to back in the mapping, so a run of them is searched as one span
+// and only a hit is traced back to the line it's on
+static void match_lines(const long first, const long last, char *scratch) {
+    if (!source_mapped) {
+        for (long line = first; line < last; line++) { match_line(line, scratch); }
+        return;
+    }
+
+    int len, last_len;
+    const char *text = mapped_log_line(first, &len);
+    const char *last_text = mapped_log_line(last - 1, &last_len);
+    if (text == NULL || last_text == NULL) { return; }
+    const char *end = last_text + last_len;
+
+    long line = first;
+    const char *from = text;
+    const char *hit;
+    while ((hit = find_query(from, end - from)) != NULL) {
+        while (hit >= text + len && line + 1 < last) { text = mapped_log_line(++line, &len); }
+        if (hit < text || hit + query_len > text + len) {
+            // Straddles a line ending
+            from = hit + 1;
+            continue;
+        }
+        push_result(line);
+        if (++line == last) { return; }
+        text = from = mapped_log_line(line, &len);
+    }
+}
+
+static int query_changed(const int generation) {
+    return SDL_AtomicGet(&query_generation) != generation || !SDL_AtomicGet(&running);
+}
+
+// Matches the query against every line seen so far, giving up as soon as it is replaced
+static void run_query(const int generation) {
+    const Uint64 start = SDL_GetPerformanceCounter();
+    char scratch[LOG_LINE_MAX];
+    long scan_from = source_mapped ? 0 : logger_first_line_id();
+
+    if (source_mapped && query_len >= 3) {
+        PostingCursor cursors[LOG_SEARCH_QUERY_MAX];
+        uint32_t buckets[LOG_SEARCH_QUERY_MAX];
+        int count = 0, empty = 0;
+        uint32_t trigram = query[0] << 8 | query[1];
+        for (int i = 2; i < query_len; i++) {
+            trigram = (trigram << 8 | query[i]) & 0xFFFFFF;
+            const uint32_t bucket = trigram_bucket(trigram);
+            int seen = 0;
+            for (int k = 0; k < count; k++) { seen |= buckets[k] == bucket; }
+            if (seen) { continue; }
+            buckets[count] = bucket;
+            cursors[count++] = cursor_begin(postings[bucket].head);
+            empty |= postings[bucket].head == NULL;
+        }
+
+        // Leapfrog intersection: every list is moved up to the highest block any of them
+        // is on until they all agree, which makes that block a candidate
+        uint32_t block = 0;
+        while (!empty) {
+            int agreed = 1;
+            for (int k = 0; k < count && agreed; k++) {
+                if (!cursor_seek(&cursors[k], block)) {
+                    empty = 1;
+                    agreed = 0;
+                } else if (cursors[k].block > block) {
+                    block = cursors[k].block;
+                    agreed = 0;
+                }
+            }
+            if (!agreed) { continue; }
+
+            const long first = (long) block << BLOCK_SHIFT;
+            match_lines(first, SDL_min(first + BLOCK_LINES, index_end), scratch);
+            if (query_changed(generation)) { return; }
+            block++;
+        }
+        scan_from = index_end;
+    }
+
+    for (long line = scan_from; line < next_line; line += SCAN_LINES) {
+        match_lines(line, SDL_min(line + SCAN_LINES, next_line), scratch);
+        if (query_changed(generation)) { return; }
+    }
+
+    queries_run++;
+    const Uint64 us = (SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+    if (us > longest_query_us) { longest_query_us = us; }
+}
+
+// Starts over whenever the panel switches source or the mapped file is replaced
+static int sync_source(void) {
+    const int mapped = mapped_log_is_open();
+    const int generation = mapped ? mapped_log_generation() : 0;
+    const long end = mapped ? mapped_log_complete_line_count() : logger_end_line_id();
+    if (mapped == source_mapped && generation == source_generation && end >= next_line) { return 0; }
+
+    reset_index();
+    source_mapped = mapped;
+    source_generation = generation;
+    next_line = mapped ? 0 : logger_first_line_id();
+    index_end = next_line;
+    tail_checked = -1;
+    return 1;
+}
+
+// Indexes and matches up to INDEX_BATCH_LINES new lines; returns 1 if more are waiting
+static int take_new_lines(void) {
+    char scratch[LOG_LINE_MAX];
+    const long end = source_mapped ? mapped_log_complete_line_count() : logger_end_line_id();
+    if (!source_mapped) { next_line = SDL_max(next_line, logger_first_line_id()); }
+    // In-memory lines are only ever scanned, so without a query there's nothing to format
+    if (!source_mapped && query_len == 0) {
+        next_line = end;
+        return 0;
+    }
+    const long last = SDL_min(end, next_line + INDEX_BATCH_LINES);
+
+    for (; next_line < last; next_line++) {
+        int len;
+        const char *text = source_line(next_line, scratch, &len);
+        if (text == NULL) { continue; }
+        if (source_mapped && index_end == next_line && index_line(next_line, text, len) == 0) {
+            index_end++;
+        }
+        if (query_len > 0 && line_matches(text, len)) { push_result(next_line); }
+    }
+
+    // An unterminated last line isn't indexed until it is complete, but can match already
+    if (source_mapped && query_len > 0 && next_line == end) {
+        int len;
+        const char *text = mapped_log_line(end, &len);
+        if (text != NULL && (tail_checked != end || tail_checked_len != len)) {
+            tail_checked = end;
+            tail_checked_len = len;
+            if (line_matches(text, len)) { push_result(end); }
+        }
+    }
+    return next_line < end;
+}
+
+static void take_query(void) {
+    SDL_AtomicLock(&query_lock);
+    query_len = (int) strlen(query_text);
+    for (int i = 0; i < query_len; i++) { query[i] = fold[(unsigned char) query_text[i]]; }
+    SDL_AtomicUnlock(&query_lock);
+    tail_checked = -1;
+}
+
+static int search_loop(void *data) {
+    int generation = 0;
+    while (SDL_AtomicGet(&running)) {
+        const int replaced = sync_source();
+        const int latest = SDL_AtomicGet(&query_generation);
+        if (latest != generation || replaced) {
+            generation = latest;
+            take_query();
+            clear_results();
+            if (query_len > 0) { run_query(generation); }
+            continue;
+        }
+
+        // A query isn't done while lines it hasn't seen are still waiting to be indexed
+        const int more = take_new_lines();
+        if (query_len > 0 && SDL_AtomicGet(&query_generation) == generation) { SDL_AtomicSet(&busy, more); }
+        if (!more) {
+            SDL_SemWaitTimeout(wake, LOG_SEARCH_POLL_MS);
+        }
+    }
+    return 0;
+}
+
+int log_search_start(void) {
+    for (int c = 0; c < 256; c++) {
+        fold[c] = (unsigned char) (c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+    source_mapped = -1;
+
+    wake = SDL_CreateSemaphore(0);
+    if (wake == NULL) { return -1; }
+    SDL_AtomicSet(&running, 1);
+
+    thread = SDL_CreateThread(search_loop, "log search", NULL);
+    if (thread == NULL) {
+        fprintf(stderr, "Failed to create log search thread: %s\n", SDL_GetError());
+        SDL_AtomicSet(&running, 0);
+        SDL_DestroySemaphore(wake);
+        return -1;
+    }
+    return 0;
+}
+
+void log_search_stop(void) {
+    if (thread == NULL) { return; }
+
+    SDL_AtomicSet(&running, 0);
+    SDL_SemPost(wake);
+    SDL_WaitThread(thread, NULL);
+    thread = NULL;
+    SDL_DestroySemaphore(wake);
+
+    reset_index();
+    for (int i = 0; i < RESULT_MAX_CHUNKS && result_chunks[i] != NULL; i++) {
+        tracked_free(result_chunks[i]);
+        result_chunks[i] = NULL;
+    }
+    SDL_AtomicSet(&result_count, 0);
+}
+
+void log_search_set_query(const char *text) {
+    if (thread == NULL) { return; }
+
+    SDL_AtomicLock(&query_lock);
+    SDL_strlcpy(query_text, text, sizeof(query_text));
+    SDL_AtomicUnlock(&query_lock);
+    SDL_AtomicSet(&busy, text[0] != '\0');
+    SDL_AtomicIncRef(&query_generation);
+    SDL_SemPost(wake);
+}
+
+int log_search_result_count(void) {
+    return SDL_AtomicGet(&result_count);
+}
+
+long log_search_result(const int index) {
+    if (index < 0 || index >= SDL_AtomicGet(&result_count)) { return -1; }
+    return result_at(index);
+}
+
+int log_search_lower_bound(const long line) {
+    int lo = 0, hi = SDL_AtomicGet(&result_count);
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (result_at(mid) < line) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int log_search_busy(void) {
+    return SDL_AtomicGet(&busy);
+}
+
+int log_search_take_update(void) {
+    return SDL_AtomicSet(&updated, 0);
+}
+
+void log_search_report(void) {
+    printf("Log search: index peaked at %ld KiB, %ld queries (longest %llu us), %ld results dropped\n",
+           peak_index_bytes / 1024, queries_run, (unsigned long long) longest_query_us, results_dropped);
+}
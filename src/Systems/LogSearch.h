@@ -0,0 +1,37 @@
+#ifndef LOG_SEARCH_H
+#define LOG_SEARCH_H
+
+#define LOG_SEARCH_QUERY_MAX 64
+
+// Case-insensitive substring search over the lines the log panel shows: the mapped file
+// when one is open, otherwise the in-memory log. A worker thread keeps a trigram index of
+// the mapped file up to date as lines are appended and runs queries against it. Matches
+// stream back as ascending line ids while a query runs, and lines appended later are
+// matched as they arrive.
+//
+// Line ids are line indices for a mapped file and logger_*_line_id ids for the in-memory log.
+int log_search_start(void);
+
+void log_search_stop(void);
+
+// Replaces the query; an empty one clears the results
+void log_search_set_query(const char *text);
+
+// Matches found so far for the current query
+int log_search_result_count(void);
+
+// Returns -1 when index is out of range
+long log_search_result(int index);
+
+// Index of the first match at or after line id, or the result count when there is none
+int log_search_lower_bound(long line);
+
+// 1 until the current query has gone through every line there is so far
+int log_search_busy(void);
+
+// Returns 1 once per batch of new matches or a cleared result set
+int log_search_take_update(void);
+
+void log_search_report(void);
+
+#endif
@@ -1,41 +1,378 @@
 #include "Logger.h"
+#include "LogFile.h"
+#include "src/Constants.h"
+#include <SDL2/SDL.h>
 #include <stdio.h>
 #include <string.h>
 
-#ifdef __APPLE__
-#define STRCAT_SAFE(dest, destsz, src) strlcat(dest, src, destsz)
-#else
-#define STRCAT_SAFE(dest, destsz, src) strcat_s(dest, destsz, src)
-#endif
+#define LOG_STORE_SIZE (256 * 1024)
+#define LOG_STORE_MASK (LOG_STORE_SIZE - 1)
+#define LOG_STORE_RECORDS 8192
+#define LOG_STORE_RECORD_MASK (LOG_STORE_RECORDS - 1)
+#define LOG_VIEW_COUNT (1 << LOG_LEVEL_COUNT)
+#define LOG_SOURCE_COUNT (LOG_MAX_FORMATS + LOG_CATEGORY_COUNT)
+#define LOG_SENDER_SLOTS 64
 
-#define LOG_BUFFER_SIZE 64000
+/*
+ * Records are packed into a byte ring in arrival order and never split across its end.
+ * offsets maps sequence numbers to the byte position each record starts at; both count
+ * up forever and wrap together, so the oldest records are evicted simply by advancing
+ * first_seq until the new one fits.
+ */
+static union {
+    LogRecord align;
+    char bytes[LOG_STORE_SIZE];
+} store;
+static unsigned offsets[LOG_STORE_RECORDS];
 
-static char logbuf[LOG_BUFFER_SIZE];
+/*
+ * Every level filter has a view: a ring of the ids of the held lines it lets through, in
+ * store order. A new line is appended to each view that shows its level and an evicted
+ * one is dropped from their fronts, so a filtered panel looks up each visible row directly
+ * instead of going through the store.
+ */
+static unsigned views[LOG_VIEW_COUNT][LOG_STORE_RECORDS];
+static unsigned view_first[LOG_VIEW_COUNT];
+static unsigned view_next[LOG_VIEW_COUNT];
+/*
+ * A line identical to the newest held one isn't stored again; the held one counts it in
+ * repeats and is shown with an "xN" suffix. The log file gets the first copy followed by a
+ * "Last line repeated" line once the run ends or LOG_SUMMARY_INTERVAL_MS passes.
+ */
+static unsigned repeats[LOG_STORE_RECORDS];
+static unsigned file_repeats;
+static LogRecord file_repeated;
+
+/*
+ * Lines that aren't repeats are rate limited per source, which is the call site's format id,
+ * or the category for preformatted text. Each source has a token bucket refilled at
+ * LOG_RATE_PER_SECOND up to LOG_RATE_BURST; lines arriving at an empty bucket are dropped and
+ * counted, and logger_update reports the counts.
+ *
+ * Relayed lines are limited per sender instead. Senders are hashed into LOG_SENDER_SLOTS
+ * buckets; senders that collide share one, and it stays named after the first until its
+ * suppressed lines have been reported.
+ */
+typedef struct {
+    double tokens;
+    Uint64 refilled;
+    unsigned suppressed;
+} RateBucket;
+
+static RateBucket buckets[LOG_SOURCE_COUNT];
+static RateBucket sender_buckets[LOG_SENDER_SLOTS];
+static int senders[LOG_SENDER_SLOTS];
+static Uint64 last_update;
+static long lines_collapsed;
+static long lines_suppressed;
+
+static unsigned store_head;
+static unsigned first_seq;
+static unsigned next_seq;
+static SDL_SpinLock store_lock;
 static int logbuf_updated = 0;
 
 void logger_init(void) {
-    logbuf[0] = '\0';
+    log_record_init();
+    store_head = 0;
+    first_seq = 0;
+    next_seq = 0;
+    memset(view_first, 0, sizeof(view_first));
+    memset(view_next, 0, sizeof(view_next));
+    file_repeats = 0;
+    const Uint64 now = SDL_GetTicks64();
+    for (int i = 0; i < LOG_SOURCE_COUNT; i++) {
+        buckets[i] = (RateBucket) {.tokens = LOG_RATE_BURST, .refilled = now};
+    }
+    for (int i = 0; i < LOG_SENDER_SLOTS; i++) {
+        sender_buckets[i] = (RateBucket) {.tokens = LOG_RATE_BURST, .refilled = now};
+        senders[i] = 0;
+    }
+    last_update = now;
+    lines_collapsed = 0;
+    lines_suppressed = 0;
     logbuf_updated = 0;
 }
 
-void write_log(const char *text) {
-    if (logbuf[0]) {
-        if (STRCAT_SAFE(logbuf, sizeof(logbuf), "\n") >= sizeof(logbuf)) {
-            fprintf(stderr, "Failed to append newline to log\n");
-            return;
-        }
+static const LogRecord *held_record(const unsigned seq) {
+    return (const LogRecord *) (store.bytes + (offsets[seq & LOG_STORE_RECORD_MASK] & LOG_STORE_MASK));
+}
+
+static unsigned level_bit(const LogRecord *record) {
+    return 1u << (record->level < LOG_LEVEL_COUNT ? record->level : LOG_LEVEL_ERROR);
+}
+
+static int is_held(const unsigned seq) {
+    return seq - first_seq < next_seq - first_seq;
+}
+
+static int is_repeat(const LogRecord *record) {
+    if (first_seq == next_seq) { return 0; }
+    const LogRecord *newest = held_record(next_seq - 1);
+    return newest->size == record->size && newest->format == record->format &&
+           newest->level == record->level && newest->category == record->category &&
+           memcmp(newest + 1, record + 1, record->size - sizeof(LogRecord)) == 0;
+}
+
+static RateBucket *sender_bucket(const int sender) {
+    const int slot = (int) ((unsigned) sender % LOG_SENDER_SLOTS);
+    if (senders[slot] != sender && sender_buckets[slot].suppressed == 0) { senders[slot] = sender; }
+    return &sender_buckets[slot];
+}
+
+static int take_token(const LogRecord *record, const int sender) {
+    const int source = record->format > 0 ? record->format : LOG_MAX_FORMATS + record->category % LOG_CATEGORY_COUNT;
+    RateBucket *bucket = sender != 0 ? sender_bucket(sender) : &buckets[source];
+    const Uint64 now = SDL_GetTicks64();
+    bucket->tokens += (double) (now - bucket->refilled) * LOG_RATE_PER_SECOND / 1000.0;
+    if (bucket->tokens > LOG_RATE_BURST) { bucket->tokens = LOG_RATE_BURST; }
+    bucket->refilled = now;
+    if (bucket->tokens < 1.0) {
+        bucket->suppressed++;
+        lines_suppressed++;
+        return 0;
     }
+    bucket->tokens -= 1.0;
+    return 1;
+}
 
-    if (STRCAT_SAFE(logbuf, sizeof(logbuf), text) >= sizeof(logbuf)) {
-        fprintf(stderr, "Failed to append text to log\n");
+PRINTF_FORMAT(5, 6)
+static void encode_line(LogRecordBuffer *buf, SDL_atomic_t *format_id, const LogCategory category,
+                        const LogLevel level, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_record_encode(buf, format_id, category, level, fmt, args);
+    va_end(args);
+}
+
+static void push_file_repeats(const LogRecord *repeated, const unsigned count) {
+    static SDL_atomic_t format_id = {-1};
+    LogRecordBuffer buf;
+    encode_line(&buf, &format_id, repeated->category, repeated->level, "Last line repeated %u more times", count);
+    log_file_push(&buf.record);
+}
+
+static void store_record(const LogRecord *record, const int sender) {
+    SDL_AtomicLock(&store_lock);
+    if (is_repeat(record)) {
+        repeats[(next_seq - 1) & LOG_STORE_RECORD_MASK]++;
+        file_repeats++;
+        file_repeated = *record;
+        lines_collapsed++;
+        logbuf_updated = 1;
+        SDL_AtomicUnlock(&store_lock);
         return;
     }
 
+    // A dropped line leaves the newest held one, and so its run of repeats, as it was
+    if (!take_token(record, sender)) {
+        SDL_AtomicUnlock(&store_lock);
+        return;
+    }
+    const unsigned repeated_count = file_repeats;
+    const LogRecord repeated = file_repeated;
+    file_repeats = 0;
+
+    unsigned pos = store_head;
+    const unsigned room = LOG_STORE_SIZE - (pos & LOG_STORE_MASK);
+    if (room < record->size) { pos += room; }
+
+    while (first_seq != next_seq &&
+           (next_seq - first_seq == LOG_STORE_RECORDS ||
+            pos + record->size - offsets[first_seq & LOG_STORE_RECORD_MASK] > LOG_STORE_SIZE)) {
+        const unsigned bit = level_bit(held_record(first_seq));
+        for (unsigned levels = 1; levels < LOG_VIEW_COUNT; levels++) {
+            if (levels & bit) { view_first[levels]++; }
+        }
+        first_seq++;
+    }
+
+    memcpy(store.bytes + (pos & LOG_STORE_MASK), record, record->size);
+    offsets[next_seq & LOG_STORE_RECORD_MASK] = pos;
+    repeats[next_seq & LOG_STORE_RECORD_MASK] = 1;
+    const unsigned bit = level_bit(record);
+    for (unsigned levels = 1; levels < LOG_VIEW_COUNT; levels++) {
+        if (levels & bit) { views[levels][view_next[levels]++ & LOG_STORE_RECORD_MASK] = next_seq; }
+    }
+    next_seq++;
+    store_head = pos + record->size;
     logbuf_updated = 1;
+    SDL_AtomicUnlock(&store_lock);
+
+    if (repeated_count > 0) { push_file_repeats(&repeated, repeated_count); }
+    log_file_push(record);
+}
+
+void write_log(const char *text) {
+    LogRecordBuffer buf;
+    log_record_encode_text(&buf, LOG_CATEGORY_APP, LOG_LEVEL_INFO, text);
+    store_record(&buf.record, 0);
+}
+
+void logger_record(SDL_atomic_t *format_id, const LogCategory category, const LogLevel level, const char *fmt, ...) {
+    LogRecordBuffer buf;
+    va_list args;
+    va_start(args, fmt);
+    log_record_encode(&buf, format_id, category, level, fmt, args);
+    va_end(args);
+    store_record(&buf.record, 0);
+}
+
+void logger_record_from(const int sender, SDL_atomic_t *format_id, const LogCategory category, const LogLevel level,
+                        const char *fmt, ...) {
+    LogRecordBuffer buf;
+    va_list args;
+    va_start(args, fmt);
+    log_record_encode(&buf, format_id, category, level, fmt, args);
+    va_end(args);
+    store_record(&buf.record, sender);
+}
+
+int logger_line_count(void) {
+    SDL_AtomicLock(&store_lock);
+    const int count = (int) (next_seq - first_seq);
+    SDL_AtomicUnlock(&store_lock);
+    return count;
+}
+
+long logger_first_line_id(void) {
+    SDL_AtomicLock(&store_lock);
+    const long id = first_seq;
+    SDL_AtomicUnlock(&store_lock);
+    return id;
+}
+
+long logger_end_line_id(void) {
+    SDL_AtomicLock(&store_lock);
+    const long id = next_seq;
+    SDL_AtomicUnlock(&store_lock);
+    return id;
+}
+
+int logger_format_line_id(const long id, char *out, const int size, const int flags) {
+    // Copy the record out so formatting doesn't hold up writers
+    LogRecordBuffer buf;
+    SDL_AtomicLock(&store_lock);
+    if (!is_held((unsigned) id)) {
+        SDL_AtomicUnlock(&store_lock);
+        return -1;
+    }
+    const LogRecord *record = held_record((unsigned) id);
+    memcpy(buf.bytes, record, record->size);
+    const unsigned count = repeats[(unsigned) id & LOG_STORE_RECORD_MASK];
+    SDL_AtomicUnlock(&store_lock);
+
+    int len = log_record_format(&buf.record, out, size, flags);
+    if (count > 1 && len < size - 1) {
+        len += snprintf(out + len, size - len, " x%u", count);
+        if (len > size - 1) { len = size - 1; }
+    }
+    return len;
+}
+
+int logger_format_line(const int index, char *out, const int size, const int flags) {
+    if (index < 0) { return -1; }
+    SDL_AtomicLock(&store_lock);
+    const unsigned seq = first_seq + (unsigned) index;
+    SDL_AtomicUnlock(&store_lock);
+    return logger_format_line_id(seq, out, size, flags);
+}
+
+int logger_line_level(const long id) {
+    SDL_AtomicLock(&store_lock);
+    const int level = is_held((unsigned) id) ? held_record((unsigned) id)->level : -1;
+    SDL_AtomicUnlock(&store_lock);
+    return level;
+}
+
+int logger_view_count(const unsigned levels) {
+    const unsigned view = levels & LOG_LEVELS_ALL;
+    SDL_AtomicLock(&store_lock);
+    const int count = (int) (view_next[view] - view_first[view]);
+    SDL_AtomicUnlock(&store_lock);
+    return count;
+}
+
+long logger_view_line_id(const unsigned levels, const int index) {
+    const unsigned view = levels & LOG_LEVELS_ALL;
+    SDL_AtomicLock(&store_lock);
+    long id = -1;
+    if (index >= 0 && (unsigned) index < view_next[view] - view_first[view]) {
+        id = views[view][(view_first[view] + index) & LOG_STORE_RECORD_MASK];
+    }
+    SDL_AtomicUnlock(&store_lock);
+    return id;
+}
+
+int logger_view_find(const unsigned levels, const long id) {
+    const unsigned view = levels & LOG_LEVELS_ALL;
+    SDL_AtomicLock(&store_lock);
+    // Ids are compared by their distance from the oldest held line, which survives wrapping
+    const int target = (int) ((unsigned) id - first_seq);
+    const int count = (int) (view_next[view] - view_first[view]);
+    int lo = target > (int) (next_seq - first_seq) ? count : 0;
+    int hi = target < 0 ? 0 : count;
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if ((int) (views[view][(view_first[view] + mid) & LOG_STORE_RECORD_MASK] - first_seq) < target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    SDL_AtomicUnlock(&store_lock);
+    return lo;
+}
+
+void logger_update(void) {
+    const Uint64 now = SDL_GetTicks64();
+    if (now - last_update < LOG_SUMMARY_INTERVAL_MS) { return; }
+    logger_flush();
+}
+
+void logger_flush(void) {
+    last_update = SDL_GetTicks64();
+
+    SDL_AtomicLock(&store_lock);
+    const unsigned repeated_count = file_repeats;
+    const LogRecord repeated = file_repeated;
+    file_repeats = 0;
+    SDL_AtomicUnlock(&store_lock);
+    if (repeated_count > 0) { push_file_repeats(&repeated, repeated_count); }
+
+    for (int source = 0; source < LOG_SOURCE_COUNT; source++) {
+        SDL_AtomicLock(&store_lock);
+        const unsigned suppressed = buckets[source].suppressed;
+        buckets[source].suppressed = 0;
+        SDL_AtomicUnlock(&store_lock);
+        if (suppressed == 0) { continue; }
+
+        if (source < LOG_MAX_FORMATS) {
+            write_logf(LOG_CATEGORY_SYSTEM, LOG_LEVEL_WARN, "Suppressed %u lines like \"%s\"", suppressed,
+                       log_record_format_string(source));
+        } else {
+            write_logf(LOG_CATEGORY_SYSTEM, LOG_LEVEL_WARN, "Suppressed %u %s lines", suppressed,
+                       log_record_category_name((LogCategory) (source - LOG_MAX_FORMATS)));
+        }
+    }
+
+    for (int slot = 0; slot < LOG_SENDER_SLOTS; slot++) {
+        SDL_AtomicLock(&store_lock);
+        const unsigned suppressed = sender_buckets[slot].suppressed;
+        const int sender = senders[slot];
+        sender_buckets[slot].suppressed = 0;
+        SDL_AtomicUnlock(&store_lock);
+        if (suppressed > 0) {
+            write_logf(LOG_CATEGORY_SYSTEM, LOG_LEVEL_WARN, "Suppressed %u lines from process %d", suppressed, sender);
+        }
+    }
 }
 
-const char *get_log_buffer(void) {
-    return logbuf;
+void logger_report(void) {
+    SDL_AtomicLock(&store_lock);
+    const long collapsed = lines_collapsed, suppressed = lines_suppressed;
+    SDL_AtomicUnlock(&store_lock);
+    printf("Logger: %ld lines collapsed into repeat counts, %ld suppressed by rate limiting\n", collapsed, suppressed);
 }
 
 int is_log_updated(void) {
@@ -1,11 +1,80 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include "LogRecord.h"
+#include "src/Constants.h"
+
+// Level filters are sets of (1 << LogLevel) bits
+#define LOG_LEVELS_ALL ((1u << LOG_LEVEL_COUNT) - 1)
+
 void logger_init(void);
 
+// An info line in the app category
 void write_log(const char *text);
 
-const char *get_log_buffer(void);
+// A line identical to the one before it is counted on that line instead of stored, and
+// each call site is rate limited to LOG_RATE_PER_SECOND lines after a burst of LOG_RATE_BURST.
+//
+// Captures the format id, category, level, timestamp and raw arguments into a binary
+// record; the text is only produced when a line is displayed or written to the log file.
+// Each call site caches its format id, so fmt must be a string literal.
+#define write_logf(category, level, ...)                                     \
+    do {                                                                     \
+        static SDL_atomic_t log_format_id_ = {-1};                           \
+        logger_record(&log_format_id_, (category), (level), __VA_ARGS__);    \
+    } while (0)
+
+void logger_record(SDL_atomic_t *format_id, LogCategory category, LogLevel level, const char *fmt, ...)
+        PRINTF_FORMAT(4, 5);
+
+// write_logf for lines relayed from other processes: they are rate limited per sender, a
+// pid, rather than per call site, so one noisy client doesn't silence the others. A sender
+// of 0 falls back to the call site.
+#define write_logf_from(sender, category, level, ...)                                   \
+    do {                                                                                \
+        static SDL_atomic_t log_format_id_ = {-1};                                      \
+        logger_record_from((sender), &log_format_id_, (category), (level), __VA_ARGS__); \
+    } while (0)
+
+void logger_record_from(int sender, SDL_atomic_t *format_id, LogCategory category, LogLevel level,
+                        const char *fmt, ...) PRINTF_FORMAT(5, 6);
+
+// Lines still held in memory, oldest first; older ones are dropped as new ones arrive
+int logger_line_count(void);
+
+// Formats line index into out with the LOG_FORMAT_* prefixes in flags. Returns its length,
+// or -1 if the line is gone.
+int logger_format_line(int index, char *out, int size, int flags);
+
+// Lines also have ids that stay put as older lines are dropped; line index has id
+// logger_first_line_id() + index
+long logger_first_line_id(void);
+
+// One past the newest line's id
+long logger_end_line_id(void);
+
+int logger_format_line_id(long id, char *out, int size, int flags);
+
+// The level of line id, or -1 if the line is gone
+int logger_line_level(long id);
+
+// Lines held whose level is in levels; with every level that's logger_line_count()
+int logger_view_count(unsigned levels);
+
+// Id of the index-th line, oldest first, of those whose level is in levels, or -1
+long logger_view_line_id(unsigned levels, int index);
+
+// Index in the levels view of the first line at or after id
+int logger_view_find(unsigned levels, long id);
+
+// Writes out pending repeat counts and one line per source whose lines were rate limited,
+// at most every LOG_SUMMARY_INTERVAL_MS. Call once per main loop iteration.
+void logger_update(void);
+
+// Writes them out now, whenever the last update was; call before the log file stops
+void logger_flush(void);
+
+void logger_report(void);
 
 int is_log_updated(void);
 
@@ -0,0 +1,346 @@
+#include "MappedLog.h"
+#include "AllocTracker.h"
+#include "src/Constants.h"
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define INDEX_CHUNK_SHIFT 16
+#define INDEX_CHUNK_SIZE (1 << INDEX_CHUNK_SHIFT)
+#define INDEX_CHUNK_MASK (INDEX_CHUNK_SIZE - 1)
+#define INDEX_MAX_CHUNKS 65536
+#define SCAN_BATCH_BYTES (4 * 1024 * 1024)
+#define MAX_RETIRED_MAPS 32
+
+#ifdef _WIN32
+
+int mapped_log_open(const char *path) {
+    fprintf(stderr, "Mapped log files are not supported on this platform\n");
+    return -1;
+}
+
+void mapped_log_close(void) {}
+
+int mapped_log_is_open(void) {
+    return 0;
+}
+
+long mapped_log_line_count(void) {
+    return 0;
+}
+
+long mapped_log_complete_line_count(void) {
+    return 0;
+}
+
+int mapped_log_generation(void) {
+    return 0;
+}
+
+const char *mapped_log_line(long index, int *len) {
+    return NULL;
+}
+
+int mapped_log_take_update(void) {
+    return 0;
+}
+
+#else
+
+/*
+ * starts[i] is the offset of line i. The index lives in fixed-size chunks that never
+ * move once allocated, so the UI thread can read lines while the indexer appends: the
+ * indexer fills entries first and then publishes line_count and indexed_end together
+ * under the spinlock.
+ *
+ * The mapping reserves MAPPED_LOG_GROWTH bytes of address space past the end of the file.
+ * Pages there become readable as the file grows, so most appends never need a remap. A file
+ * that outgrows it (every append, on 32-bit builds, which reserve nothing) is mapped again at
+ * least twice as large and swapped in under the spinlock. Old mappings stay until close,
+ * since lines handed out point into them.
+ */
+static uint64_t *chunks[INDEX_MAX_CHUNKS];
+static long newline_count;
+static uint64_t indexed_end;
+static SDL_SpinLock index_lock;
+
+static int fd = -1;
+static int watch_fd = -1;
+static const char *map;
+static size_t map_size;
+static struct {
+    const char *map;
+    size_t size;
+} retired[MAX_RETIRED_MAPS];
+static int retired_count;
+static SDL_Thread *thread;
+static SDL_atomic_t running;
+static SDL_atomic_t updated;
+static SDL_atomic_t generation;
+
+// Appends the start of a line; only the indexer thread calls this
+static int push_start(const long line, const uint64_t offset) {
+    const long chunk = line >> INDEX_CHUNK_SHIFT;
+    if (chunk >= INDEX_MAX_CHUNKS) { return -1; }
+    if (chunks[chunk] == NULL) {
+        chunks[chunk] = tracked_malloc(ALLOC_LOG, INDEX_CHUNK_SIZE * sizeof(uint64_t));
+        if (chunks[chunk] == NULL) { return -1; }
+    }
+    chunks[chunk][line & INDEX_CHUNK_MASK] = offset;
+    return 0;
+}
+
+static uint64_t line_start(const long line) {
+    return chunks[line >> INDEX_CHUNK_SHIFT][line & INDEX_CHUNK_MASK];
+}
+
+// Records every newline in [from, to), returning the new newline count or -1 when the
+// index is full
+static long scan_newlines(const uint64_t from, const uint64_t to, long count) {
+    uint64_t pos = from;
+
+#ifdef __SSE2__
+    // 16 bytes at a time: compare against '\n' and walk the set bits of the mask
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; pos + 16 <= to; pos += 16) {
+        const __m128i block = _mm_loadu_si128((const __m128i *) (map + pos));
+        unsigned mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        while (mask) {
+            if (push_start(++count, pos + __builtin_ctz(mask) + 1) != 0) { return -1; }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    while (pos < to) {
+        const char *hit = memchr(map + pos, '\n', to - pos);
+        if (hit == NULL) { break; }
+        pos = (uint64_t) (hit - map) + 1;
+        if (push_start(++count, pos) != 0) { return -1; }
+    }
+    return count;
+}
+
+static void publish(const long count, const uint64_t end) {
+    SDL_AtomicLock(&index_lock);
+    newline_count = count;
+    indexed_end = end;
+    SDL_AtomicUnlock(&index_lock);
+    SDL_AtomicSet(&updated, 1);
+}
+
+// Address space to map for a file of size bytes; without 64-bit address space there's no
+// room to reserve for growth
+static uint64_t mapping_for(const uint64_t size) {
+    return size + (SIZE_MAX > UINT32_MAX ? MAPPED_LOG_GROWTH : 0);
+}
+
+// Maps the file again to cover size bytes; only the indexer thread calls this
+static int grow_mapping(const uint64_t size) {
+    if (retired_count == MAX_RETIRED_MAPS) { return -1; }
+    uint64_t want = mapping_for(size);
+    if (want < (uint64_t) map_size * 2 && (uint64_t) map_size * 2 <= SIZE_MAX) { want = (uint64_t) map_size * 2; }
+    if (want > SIZE_MAX) { return -1; }
+
+    const char *grown = mmap(NULL, (size_t) want, PROT_READ, MAP_SHARED, fd, 0);
+    if (grown == MAP_FAILED) { return -1; }
+
+    retired[retired_count].map = map;
+    retired[retired_count].size = map_size;
+    retired_count++;
+    SDL_AtomicLock(&index_lock);
+    map = grown;
+    SDL_AtomicUnlock(&index_lock);
+    map_size = (size_t) want;
+    return 0;
+}
+
+// Sleeps until the file may have grown: an inotify event where available, otherwise the
+// next MAPPED_LOG_POLL_MS tick
+static void wait_for_growth(void) {
+#ifdef __linux__
+    if (watch_fd >= 0) {
+        struct pollfd p = {.fd = watch_fd, .events = POLLIN};
+        if (poll(&p, 1, MAPPED_LOG_POLL_MS) > 0) {
+            char events[4096];
+            while (read(watch_fd, events, sizeof(events)) > 0) {}
+        }
+        return;
+    }
+#endif
+    SDL_Delay(MAPPED_LOG_POLL_MS);
+}
+
+static int index_loop(void *data) {
+    long count = 0;
+    uint64_t end = 0;
+
+    while (SDL_AtomicGet(&running)) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) { break; }
+        uint64_t size = (uint64_t) st.st_size;
+        if (size > map_size && grow_mapping(size) != 0) {
+            size = map_size;
+            if (end == size) {
+                fprintf(stderr, "Log file outgrew its mapping; stopped following after %ld lines\n", count);
+                break;
+            }
+        }
+
+        if (size < end) {
+            // Truncated in place: start over from the top
+            count = 0;
+            end = 0;
+            publish(0, 0);
+            SDL_AtomicIncRef(&generation);
+        }
+        if (size == end) {
+            wait_for_growth();
+            continue;
+        }
+
+        // Publishing per batch lets the first screens of a large file show immediately
+        const uint64_t to = size - end > SCAN_BATCH_BYTES ? end + SCAN_BATCH_BYTES : size;
+        count = scan_newlines(end, to, count);
+        if (count < 0) {
+            fprintf(stderr, "Log index full; showing the first %ld lines\n", newline_count);
+            break;
+        }
+        end = to;
+        publish(count, end);
+    }
+    return 0;
+}
+
+int mapped_log_open(const char *path) {
+    mapped_log_close();
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        mapped_log_close();
+        return -1;
+    }
+
+    map_size = (size_t) mapping_for((uint64_t) st.st_size);
+    map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s: %s\n", path, strerror(errno));
+        map = NULL;
+        mapped_log_close();
+        return -1;
+    }
+    madvise((void *) map, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+#ifdef __linux__
+    watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch_fd >= 0 && inotify_add_watch(watch_fd, path, IN_MODIFY) < 0) {
+        close(watch_fd);
+        watch_fd = -1;
+    }
+#endif
+
+    if (push_start(0, 0) != 0) {
+        mapped_log_close();
+        return -1;
+    }
+    publish(0, 0);
+    SDL_AtomicIncRef(&generation);
+    SDL_AtomicSet(&running, 1);
+    thread = SDL_CreateThread(index_loop, "log index", NULL);
+    if (thread == NULL) {
+        fprintf(stderr, "Failed to create log index thread: %s\n", SDL_GetError());
+        mapped_log_close();
+        return -1;
+    }
+    return 0;
+}
+
+void mapped_log_close(void) {
+    if (thread != NULL) {
+        SDL_AtomicSet(&running, 0);
+        SDL_WaitThread(thread, NULL);
+        thread = NULL;
+    }
+    if (watch_fd >= 0) { close(watch_fd); }
+    if (map != NULL) { munmap((void *) map, map_size); }
+    for (int i = 0; i < retired_count; i++) { munmap((void *) retired[i].map, retired[i].size); }
+    retired_count = 0;
+    if (fd >= 0) { close(fd); }
+    watch_fd = -1;
+    map = NULL;
+    fd = -1;
+
+    for (int i = 0; i < INDEX_MAX_CHUNKS && chunks[i] != NULL; i++) {
+        tracked_free(chunks[i]);
+        chunks[i] = NULL;
+    }
+    newline_count = 0;
+    indexed_end = 0;
+}
+
+int mapped_log_is_open(void) {
+    return map != NULL;
+}
+
+long mapped_log_line_count(void) {
+    SDL_AtomicLock(&index_lock);
+    const long count = newline_count;
+    const int tail = map != NULL && indexed_end > line_start(count);
+    SDL_AtomicUnlock(&index_lock);
+    return count + tail;
+}
+
+long mapped_log_complete_line_count(void) {
+    SDL_AtomicLock(&index_lock);
+    const long count = newline_count;
+    SDL_AtomicUnlock(&index_lock);
+    return count;
+}
+
+int mapped_log_generation(void) {
+    return SDL_AtomicGet(&generation);
+}
+
+const char *mapped_log_line(const long index, int *len) {
+    SDL_AtomicLock(&index_lock);
+    const char *lines = map;
+    const long count = newline_count;
+    const uint64_t end_of_index = indexed_end;
+    SDL_AtomicUnlock(&index_lock);
+    if (lines == NULL || index < 0 || index > count) { return NULL; }
+
+    const uint64_t start = line_start(index);
+    uint64_t end = index < count ? line_start(index + 1) - 1 : end_of_index;
+    if (index == count && start >= end) { return NULL; }
+    if (end > start && lines[end - 1] == '\r') { end--; }
+
+    const uint64_t length = end - start;
+    *len = length > INT32_MAX ? INT32_MAX : (int) length;
+    return lines + start;
+}
+
+int mapped_log_take_update(void) {
+    return SDL_AtomicSet(&updated, 0);
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MAPPED_LOG_H
+#define MAPPED_LOG_H
+
+// A log file viewed in place. The file is mapped read-only and a background thread builds
+// the line index, so lines can be shown before indexing finishes and come straight from
+// the mapping. Appended data is picked up as the file grows; files should be rotated by
+// rename, since truncating one in place while it is open isn't safe to read through.
+// A file that outgrows its mapping is mapped again; if that fails, following stops with a
+// message on stderr and the lines indexed so far stay.
+// Growth past the reserved address space needs an in-place remap (Linux only); where that
+// fails, following stops with a message on stderr and the lines indexed so far stay.
+int mapped_log_open(const char *path);
+
+void mapped_log_close(void);
+
+int mapped_log_is_open(void);
+
+// Lines indexed so far, including an unterminated last line
+long mapped_log_line_count(void);
+
+// Lines indexed so far that end in a newline and so won't change any more
+long mapped_log_complete_line_count(void);
+
+// Changes whenever the indexed lines are replaced rather than appended to: on open and
+// when the file is truncated
+int mapped_log_generation(void);
+
+// Points into the mapping; the line is len bytes long without its line ending and isn't
+// NUL-terminated. Returns NULL past the indexed lines.
+const char *mapped_log_line(long index, int *len);
+
+// Returns 1 once per batch of newly indexed lines
+int mapped_log_take_update(void);
+
+#endif
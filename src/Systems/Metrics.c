@@ -0,0 +1,87 @@
+#include "Metrics.h"
+#include "TimeSeries.h"
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define METRICS_HASH_SIZE (METRICS_MAX * 2)
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+typedef struct {
+    char name[METRIC_NAME_MAX];
+    double value;
+    long updates;
+    int series;
+} Metric;
+
+// Metrics in the order they were first seen; hash holds index + 1, probed linearly
+static Metric metrics[METRICS_MAX];
+static int metric_count;
+static short hash[METRICS_HASH_SIZE];
+static long non_finite;
+
+static int find_or_add(const char *name) {
+    const size_t len = strnlen(name, METRIC_NAME_MAX - 1);
+    unsigned h = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (unsigned char) name[i]) * FNV_PRIME;
+    }
+
+    for (unsigned slot = h % METRICS_HASH_SIZE;; slot = (slot + 1) % METRICS_HASH_SIZE) {
+        const int index = hash[slot] - 1;
+        if (index < 0) {
+            if (metric_count == METRICS_MAX) { return -1; }
+            memcpy(metrics[metric_count].name, name, len);
+            metrics[metric_count].name[len] = '\0';
+            metrics[metric_count].series = time_series_open(metrics[metric_count].name);
+            hash[slot] = (short) (metric_count + 1);
+            return metric_count++;
+        }
+        if (strncmp(metrics[index].name, name, len) == 0 && metrics[index].name[len] == '\0') {
+            return index;
+        }
+    }
+}
+
+int metrics_set(const char *name, const double value) {
+    // Plots and series can't place NaN or infinity
+    if (!isfinite(value)) {
+        non_finite++;
+        return -1;
+    }
+    const int index = find_or_add(name);
+    if (index < 0) { return -1; }
+    metrics[index].value = value;
+    metrics[index].updates++;
+    time_series_add(metrics[index].series, SDL_GetTicks64(), value);
+    return index;
+}
+
+int metrics_count(void) {
+    return metric_count;
+}
+
+const char *metrics_name(const int index) {
+    return index >= 0 && index < metric_count ? metrics[index].name : NULL;
+}
+
+double metrics_value(const int index) {
+    return index >= 0 && index < metric_count ? metrics[index].value : 0.0;
+}
+
+long metrics_updates(const int index) {
+    return index >= 0 && index < metric_count ? metrics[index].updates : 0;
+}
+
+int metrics_series(const int index) {
+    return index >= 0 && index < metric_count ? metrics[index].series : -1;
+}
+
+void metrics_report(void) {
+    printf("Metrics: %d (%ld non-finite values rejected)\n", metric_count, non_finite);
+    for (int i = 0; i < metric_count; i++) {
+        printf("  %-32s %14.4g %10ld updates\n", metrics[i].name, metrics[i].value, metrics[i].updates);
+    }
+}
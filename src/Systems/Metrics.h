@@ -0,0 +1,29 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#define METRICS_MAX 256
+#define METRIC_NAME_MAX 48
+
+// Named metrics holding the latest value reported for each. Names are hashed into a fixed
+// table, so reporting a value never allocates. Every value is also added, timestamped, to
+// the metric's time series while there are series left. Only the UI thread touches them.
+
+// Returns the metric's index, or -1 when value is NaN or infinite or the table is full.
+// Names longer than METRIC_NAME_MAX - 1 are cut.
+int metrics_set(const char *name, double value);
+
+int metrics_count(void);
+
+const char *metrics_name(int index);
+
+double metrics_value(int index);
+
+// Values reported for the metric so far
+long metrics_updates(int index);
+
+// The metric's time series, or -1 if it has none
+int metrics_series(int index);
+
+void metrics_report(void);
+
+#endif
@@ -0,0 +1,75 @@
+#include "Profiler.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+#define PROFILER_MAX_PHASES 16
+
+typedef struct {
+    const char *name;
+    Uint64 counter;
+} Phase;
+
+static Uint64 startup_counter;
+static Phase phases[PROFILER_MAX_PHASES];
+static int phase_count;
+static int startup_trace;
+static int startup_done;
+
+static long counters[PROFILER_COUNTER_COUNT];
+static const char *counter_names[PROFILER_COUNTER_COUNT] = {
+    [PROFILER_FRAMES_DRAWN] = "frames drawn",
+    [PROFILER_FRAMES_UNFOCUSED] = "frames unfocused",
+    [PROFILER_HIDDEN_WAITS] = "hidden waits",
+    [PROFILER_HIDDEN_MS] = "hidden ms",
+    [PROFILER_FORMAT_HITS] = "format cache hits",
+    [PROFILER_FORMAT_MISSES] = "format cache misses",
+    [PROFILER_ARENA_OVERFLOWS] = "arena overflows",
+};
+
+void profiler_startup_begin(void) {
+    startup_counter = SDL_GetPerformanceCounter();
+    phase_count = 0;
+    startup_done = 0;
+}
+
+void profiler_set_startup_trace(const int enabled) {
+    startup_trace = enabled;
+}
+
+void profiler_startup_mark(const char *phase) {
+    if (startup_done || phase_count == PROFILER_MAX_PHASES) { return; }
+    phases[phase_count].name = phase;
+    phases[phase_count].counter = SDL_GetPerformanceCounter();
+    phase_count++;
+}
+
+void profiler_startup_finish(const char *phase) {
+    if (startup_done) { return; }
+    profiler_startup_mark(phase);
+    startup_done = 1;
+    if (!startup_trace) { return; }
+
+    const double ms_per_tick = 1000.0 / SDL_GetPerformanceFrequency();
+    Uint64 previous = startup_counter;
+    printf("Startup trace:\n");
+    for (int i = 0; i < phase_count; i++) {
+        printf("  %-20s %8.2f ms\n", phases[i].name, (phases[i].counter - previous) * ms_per_tick);
+        previous = phases[i].counter;
+    }
+    printf("  %-20s %8.2f ms\n", "time to first frame", (previous - startup_counter) * ms_per_tick);
+}
+
+void profiler_count(const ProfilerCounter counter, const long amount) {
+    counters[counter] += amount;
+}
+
+long profiler_get(const ProfilerCounter counter) {
+    return counters[counter];
+}
+
+void profiler_report(void) {
+    printf("Profiler counters:\n");
+    for (int i = 0; i < PROFILER_COUNTER_COUNT; i++) {
+        printf("  %-20s %10ld\n", counter_names[i], counters[i]);
+    }
+}
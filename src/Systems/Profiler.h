@@ -0,0 +1,33 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Startup phases are timed from profiler_startup_begin to each mark. The last phase is
+// closed with profiler_startup_finish, which prints the breakdown in --startup-trace mode.
+void profiler_startup_begin(void);
+
+void profiler_set_startup_trace(int enabled);
+
+void profiler_startup_mark(const char *phase);
+
+void profiler_startup_finish(const char *phase);
+
+typedef enum {
+    PROFILER_FRAMES_DRAWN,
+    PROFILER_FRAMES_UNFOCUSED,
+    PROFILER_HIDDEN_WAITS,
+    PROFILER_HIDDEN_MS,
+    PROFILER_FORMAT_HITS,
+    PROFILER_FORMAT_MISSES,
+    PROFILER_ARENA_OVERFLOWS,
+    PROFILER_COUNTER_COUNT
+} ProfilerCounter;
+
+// Counters are only touched from the UI thread
+void profiler_count(ProfilerCounter counter, long amount);
+
+long profiler_get(ProfilerCounter counter);
+
+// Prints every counter
+void profiler_report(void);
+
+#endif
@@ -0,0 +1,72 @@
+#include "ShmIngest.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "src/Client/ShmRing.h"
+#include "src/Constants.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+static ShmRing *ring;
+static const char *ring_name;
+static uint32_t reported_dropped;
+static Uint64 last_drop_report;
+static long lines_received;
+static long metrics_received;
+static long metrics_rejected;
+static int most_in_one_drain;
+static uint32_t producer_dropped;
+
+int shm_ingest_open(const char *name) {
+    ring = shm_ring_create(name);
+    if (ring == NULL) { return -1; }
+    ring_name = name;
+    reported_dropped = 0;
+    last_drop_report = SDL_GetTicks64();
+    return 0;
+}
+
+static void report_drops(void) {
+    const Uint64 now = SDL_GetTicks64();
+    if (now - last_drop_report < LOG_SUMMARY_INTERVAL_MS) { return; }
+    last_drop_report = now;
+
+    const uint32_t dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    if (dropped != reported_dropped) {
+        write_logf(LOG_CATEGORY_SYSTEM, LOG_LEVEL_WARN, "External producers dropped %u messages, the ring was full",
+                   dropped - reported_dropped);
+        reported_dropped = dropped;
+    }
+}
+
+void shm_ingest_drain(void) {
+    if (ring == NULL) { return; }
+
+    ShmMessage message;
+    int count = 0;
+    while (count < SHM_DRAIN_PER_FRAME && shm_ring_pop(ring, &message)) {
+        count++;
+        if (message.type == SHM_MESSAGE_LOG) {
+            const LogLevel level = message.level < LOG_LEVEL_COUNT ? (LogLevel) message.level : LOG_LEVEL_ERROR;
+            write_logf_from(message.pid, LOG_CATEGORY_EXTERNAL, level, "[%d] %s", message.pid, message.text);
+            lines_received++;
+        } else if (message.type == SHM_MESSAGE_METRIC) {
+            if (metrics_set(message.text, message.value) < 0) { metrics_rejected++; }
+            metrics_received++;
+        }
+    }
+    if (count > most_in_one_drain) { most_in_one_drain = count; }
+    if (count > 0) { metrics_set("ingest.shm.messages", (double) (lines_received + metrics_received)); }
+    report_drops();
+}
+
+void shm_ingest_close(void) {
+    if (ring != NULL) { producer_dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed); }
+    shm_ring_destroy(ring, ring_name);
+    ring = NULL;
+}
+
+void shm_ingest_report(void) {
+    printf("Shared-memory ingest: %ld lines, %ld metrics (%ld rejected), %u dropped by producers, "
+           "most in one frame %d\n", lines_received, metrics_received, metrics_rejected, producer_dropped,
+           most_in_one_drain);
+}
@@ -0,0 +1,17 @@
+#ifndef SHM_INGEST_H
+#define SHM_INGEST_H
+
+// Receives log lines and metrics from other processes through the shared-memory ring the
+// SifeClient library (src/Client) publishes to. Lines go to the logger in the external
+// category and metrics to the metrics table.
+int shm_ingest_open(const char *name);
+
+// Moves up to SHM_DRAIN_PER_FRAME queued messages; call once per frame on the UI thread.
+// Anything left waits for the next frame, and producers drop what doesn't fit meanwhile.
+void shm_ingest_drain(void);
+
+void shm_ingest_close(void);
+
+void shm_ingest_report(void);
+
+#endif
@@ -0,0 +1,491 @@
+// accept4 and struct ucred
+#define _GNU_SOURCE
+
+#include "SocketIngest.h"
+#include "AllocTracker.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "src/Constants.h"
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#define BATCH_LINES_MAX 2048
+#define BATCH_QUEUE_MASK (SOCKET_BATCH_COUNT - 1)
+#define READS_PER_WAKE 4
+#define EPOLL_EVENTS 64
+#define LISTEN_ID SOCKET_MAX_CONNECTIONS
+#define WAKE_ID (SOCKET_MAX_CONNECTIONS + 1)
+
+_Static_assert((SOCKET_BATCH_COUNT & BATCH_QUEUE_MASK) == 0, "SOCKET_BATCH_COUNT must be a power of two");
+_Static_assert(SOCKET_BATCH_BYTES <= 65536, "line starts are 16-bit");
+
+#ifndef __linux__
+
+int socket_ingest_open(const char *path) {
+    fprintf(stderr, "Socket ingestion needs epoll and is only available on Linux\n");
+    return -1;
+}
+
+void socket_ingest_drain(void) {}
+
+void socket_ingest_close(void) {}
+
+void socket_ingest_report(void) {}
+
+#else
+
+/*
+ * A connection reads straight into a batch taken from the pool. Each newline found is
+ * overwritten with a NUL and the line's start recorded, so lines reach the UI thread in
+ * the bytes read() put them in. Once a read leaves complete lines, the batch is queued for
+ * the UI and only what follows them, the unfinished line or lines past BATCH_LINES_MAX, is
+ * copied into a fresh batch. The UI thread hands drained batches back through a second
+ * queue.
+ *
+ * Both queues are single-producer, single-consumer rings of batch indices, never fuller
+ * than the pool. When the pool runs dry a connection stops being read until batches come
+ * back, which pushes back on its client through the socket buffer.
+ */
+typedef struct {
+    int pid;
+    int used;
+    int line_count;
+    unsigned short starts[BATCH_LINES_MAX];
+    char data[SOCKET_BATCH_BYTES];
+} Batch;
+
+typedef struct {
+    int slots[SOCKET_BATCH_COUNT];
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+} BatchQueue;
+
+typedef struct {
+    int fd;
+    int pid;
+    int batch;
+    // Where the unfinished line starts in the batch and how far it has been searched
+    int line_start;
+    int scanned;
+    // Skipping the rest of a line too long for a batch
+    int discarding;
+    int stalled;
+} Connection;
+
+typedef struct {
+    Batch batches[SOCKET_BATCH_COUNT];
+    BatchQueue ready;
+    BatchQueue free;
+    Connection connections[SOCKET_MAX_CONNECTIONS];
+    char path[sizeof(((struct sockaddr_un *) 0)->sun_path)];
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;
+    int stalled_count;
+    SDL_Thread *thread;
+
+    // The batch the UI thread is draining, plus one, and its next line
+    int draining;
+    int drain_line;
+} SocketIngest;
+
+static SocketIngest *ingest;
+
+// Ingest thread statistics, read once it has stopped
+static long accepted;
+static long rejected;
+static long bytes_read;
+static long lines_cut;
+static long stalls;
+
+// UI thread statistics
+static long lines_received;
+static long metrics_received;
+static long metrics_rejected;
+static int most_in_one_drain;
+static double longest_drain_us;
+
+static int queue_empty(BatchQueue *q) {
+    return SDL_AtomicGet(&q->tail) == SDL_AtomicGet(&q->head);
+}
+
+static void queue_push(BatchQueue *q, const int index) {
+    const int head = SDL_AtomicGet(&q->head);
+    q->slots[head & BATCH_QUEUE_MASK] = index;
+    SDL_AtomicSet(&q->head, head + 1);
+}
+
+static int queue_pop(BatchQueue *q) {
+    if (queue_empty(q)) { return -1; }
+    const int tail = SDL_AtomicGet(&q->tail);
+    const int index = q->slots[tail & BATCH_QUEUE_MASK];
+    SDL_AtomicSet(&q->tail, tail + 1);
+    return index;
+}
+
+static void watch(const int fd, const unsigned id, const int op, const unsigned events) {
+    struct epoll_event event = {.events = events, .data.u32 = id};
+    epoll_ctl(ingest->epoll_fd, op, fd, &event);
+}
+
+// Takes the connection out of epoll altogether, since a hangup would still be reported
+static void stall(Connection *c) {
+    if (c->stalled) { return; }
+    epoll_ctl(ingest->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    c->stalled = 1;
+    ingest->stalled_count++;
+    stalls++;
+}
+
+static void add_line(Batch *b, const int start) {
+    b->starts[b->line_count++] = (unsigned short) start;
+}
+
+// Terminates every complete line read since the last call, stopping early if the batch
+// can't take more lines
+static void split_lines(Connection *c, Batch *b) {
+    while (c->scanned < b->used && b->line_count < BATCH_LINES_MAX) {
+        char *newline = memchr(b->data + c->scanned, '\n', b->used - c->scanned);
+        if (newline == NULL) {
+            c->scanned = b->used;
+            break;
+        }
+        const int end = (int) (newline - b->data);
+        *newline = '\0';
+        if (end > c->line_start && b->data[end - 1] == '\r') { b->data[end - 1] = '\0'; }
+        if (!c->discarding && end > c->line_start) { add_line(b, c->line_start); }
+        c->discarding = 0;
+        c->line_start = end + 1;
+        c->scanned = end + 1;
+    }
+
+    if (c->discarding) {
+        // Nothing of an overlong line is kept past the part already cut off
+        b->used = c->line_start;
+        c->scanned = c->line_start;
+    } else if (c->line_start == 0 && b->used == SOCKET_BATCH_BYTES - 1) {
+        b->data[b->used] = '\0';
+        add_line(b, 0);
+        c->line_start = b->used;
+        c->scanned = b->used;
+        c->discarding = 1;
+        lines_cut++;
+    }
+}
+
+// Queues the batch's complete lines for the UI, moving the rest into a fresh batch and
+// splitting the lines there that the full one had no room for. Returns 0 when the pool
+// has no batch for it.
+static int hand_off(Connection *c) {
+    Batch *b = &ingest->batches[c->batch];
+    const int tail = b->used - c->line_start;
+    int next = -1;
+    if (tail > 0) {
+        next = queue_pop(&ingest->free);
+        if (next < 0) { return 0; }
+        Batch *nb = &ingest->batches[next];
+        memcpy(nb->data, b->data + c->line_start, tail);
+        nb->used = tail;
+        nb->line_count = 0;
+        nb->pid = c->pid;
+    }
+    queue_push(&ingest->ready, c->batch);
+    c->batch = next;
+    c->scanned -= c->line_start;
+    c->line_start = 0;
+    if (next >= 0) { split_lines(c, &ingest->batches[next]); }
+    return 1;
+}
+
+// Hands off batches until the connection's holds no complete lines. Returns 0 when the
+// pool runs dry first.
+static int hand_off_lines(Connection *c) {
+    while (c->batch >= 0 && ingest->batches[c->batch].line_count > 0) {
+        if (!hand_off(c)) { return 0; }
+    }
+    return 1;
+}
+
+static void close_connection(Connection *c) {
+    if (c->batch >= 0) {
+        // Lines a full batch had no room for follow in fresh ones while the pool lasts
+        while (ingest->batches[c->batch].line_count == BATCH_LINES_MAX && hand_off(c)) {}
+        Batch *b = &ingest->batches[c->batch];
+        if (!c->discarding && b->used > c->line_start && b->line_count < BATCH_LINES_MAX) {
+            b->data[b->used] = '\0';
+            add_line(b, c->line_start);
+        }
+        // Even an empty batch goes back through the UI thread, the free queue's only producer
+        queue_push(&ingest->ready, c->batch);
+    }
+    if (c->stalled) {
+        ingest->stalled_count--;
+    } else {
+        epoll_ctl(ingest->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    }
+    close(c->fd);
+    *c = (Connection) {.fd = -1, .batch = -1};
+}
+
+static void service(Connection *c) {
+    for (int reads = 0; reads < READS_PER_WAKE;) {
+        if (c->batch < 0) {
+            c->batch = queue_pop(&ingest->free);
+            if (c->batch < 0) {
+                stall(c);
+                return;
+            }
+            Batch *b = &ingest->batches[c->batch];
+            b->used = 0;
+            b->line_count = 0;
+            b->pid = c->pid;
+            c->line_start = 0;
+            c->scanned = 0;
+        }
+
+        Batch *b = &ingest->batches[c->batch];
+        if (b->line_count == BATCH_LINES_MAX || b->used == SOCKET_BATCH_BYTES - 1) {
+            if (!hand_off(c)) {
+                stall(c);
+                return;
+            }
+            continue;
+        }
+
+        // One byte stays free so a cut or final line can always be terminated
+        const ssize_t n = read(c->fd, b->data + b->used, SOCKET_BATCH_BYTES - 1 - b->used);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!hand_off_lines(c)) { stall(c); }
+            return;
+        }
+        if (n <= 0) {
+            // Waits for the pool rather than dropping lines the client sent before closing
+            if (!hand_off_lines(c)) {
+                stall(c);
+                return;
+            }
+            close_connection(c);
+            return;
+        }
+        reads++;
+        b->used += (int) n;
+        bytes_read += n;
+        split_lines(c, b);
+    }
+
+    // Level-triggered, so whatever is left is picked up on the next wait
+    if (!hand_off_lines(c)) { stall(c); }
+}
+
+static void accept_connections(void) {
+    for (;;) {
+        const int fd = accept4(ingest->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) { return; }
+
+        Connection *c = NULL;
+        for (int i = 0; i < SOCKET_MAX_CONNECTIONS && c == NULL; i++) {
+            if (ingest->connections[i].fd < 0) { c = &ingest->connections[i]; }
+        }
+        if (c == NULL) {
+            close(fd);
+            rejected++;
+            continue;
+        }
+
+        struct ucred cred;
+        socklen_t len = sizeof(cred);
+        *c = (Connection) {.fd = fd, .batch = -1};
+        c->pid = getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 ? cred.pid : 0;
+        watch(fd, (unsigned) (c - ingest->connections), EPOLL_CTL_ADD, EPOLLIN);
+        accepted++;
+    }
+}
+
+static void retry_stalled(void) {
+    if (queue_empty(&ingest->free)) { return; }
+    for (int i = 0; i < SOCKET_MAX_CONNECTIONS && ingest->stalled_count > 0; i++) {
+        Connection *c = &ingest->connections[i];
+        if (!c->stalled) { continue; }
+        c->stalled = 0;
+        ingest->stalled_count--;
+        watch(c->fd, (unsigned) i, EPOLL_CTL_ADD, EPOLLIN);
+        // A batch waiting on the pool for its unfinished line gets another go first
+        if (!hand_off_lines(c)) {
+            stall(c);
+            continue;
+        }
+        service(c);
+    }
+}
+
+static int ingest_thread(void *data) {
+    struct epoll_event events[EPOLL_EVENTS];
+    for (;;) {
+        const int timeout = ingest->stalled_count > 0 ? SOCKET_STALL_RETRY_MS : -1;
+        const int count = epoll_wait(ingest->epoll_fd, events, EPOLL_EVENTS, timeout);
+        if (count < 0 && errno != EINTR) {
+            fprintf(stderr, "Socket ingestion stopped: %s\n", strerror(errno));
+            return -1;
+        }
+
+        for (int i = 0; i < count; i++) {
+            const unsigned id = events[i].data.u32;
+            if (id == WAKE_ID) { return 0; }
+            if (id == LISTEN_ID) {
+                accept_connections();
+            } else if (ingest->connections[id].fd >= 0) {
+                service(&ingest->connections[id]);
+            }
+        }
+        retry_stalled();
+    }
+}
+
+int socket_ingest_open(const char *path) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    ingest = tracked_calloc(ALLOC_LOG, 1, sizeof(SocketIngest));
+    if (ingest == NULL) { return -1; }
+
+    strcpy(addr.sun_path, path);
+    strcpy(ingest->path, path);
+    for (int i = 0; i < SOCKET_MAX_CONNECTIONS; i++) {
+        ingest->connections[i] = (Connection) {.fd = -1, .batch = -1};
+    }
+    for (int i = 0; i < SOCKET_BATCH_COUNT; i++) {
+        queue_push(&ingest->free, i);
+    }
+
+    unlink(path);
+    ingest->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ingest->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    ingest->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ingest->listen_fd < 0 || ingest->epoll_fd < 0 || ingest->wake_fd < 0 ||
+        bind(ingest->listen_fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+        listen(ingest->listen_fd, SOMAXCONN) != 0) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", path, strerror(errno));
+        socket_ingest_close();
+        return -1;
+    }
+    watch(ingest->listen_fd, LISTEN_ID, EPOLL_CTL_ADD, EPOLLIN);
+    watch(ingest->wake_fd, WAKE_ID, EPOLL_CTL_ADD, EPOLLIN);
+
+    ingest->thread = SDL_CreateThread(ingest_thread, "socket ingest", NULL);
+    if (ingest->thread == NULL) {
+        fprintf(stderr, "Failed to start socket ingestion: %s\n", SDL_GetError());
+        socket_ingest_close();
+        return -1;
+    }
+    printf("Accepting log lines on %s\n", path);
+    return 0;
+}
+
+static LogLevel take_level(const char **text) {
+    static const char *prefixes[LOG_LEVEL_COUNT] = {"debug ", "info ", "warn ", "error "};
+    for (int level = 0; level < LOG_LEVEL_COUNT; level++) {
+        const size_t len = strlen(prefixes[level]);
+        if (strncmp(*text, prefixes[level], len) == 0) {
+            *text += len;
+            return (LogLevel) level;
+        }
+    }
+    return LOG_LEVEL_INFO;
+}
+
+static void ingest_line(const int pid, char *line) {
+    if (strncmp(line, "metric ", 7) == 0) {
+        char *name = line + 7;
+        char *value = strrchr(name, ' ');
+        if (value != NULL && value > name) {
+            *value++ = '\0';
+            char *end;
+            const double v = strtod(value, &end);
+            if (end != value) {
+                if (metrics_set(name, v) < 0) { metrics_rejected++; }
+                metrics_received++;
+                return;
+            }
+        }
+    }
+
+    const char *text = line;
+    const LogLevel level = take_level(&text);
+    write_logf_from(pid, LOG_CATEGORY_EXTERNAL, level, "[%d] %s", pid, text);
+    lines_received++;
+}
+
+void socket_ingest_drain(void) {
+    if (ingest == NULL) { return; }
+
+    const Uint64 start = SDL_GetPerformanceCounter();
+    int lines = 0;
+    while (lines < SOCKET_DRAIN_LINES) {
+        if (!ingest->draining) {
+            const int index = queue_pop(&ingest->ready);
+            if (index < 0) { break; }
+            ingest->draining = index + 1;
+            ingest->drain_line = 0;
+        }
+
+        Batch *b = &ingest->batches[ingest->draining - 1];
+        for (; ingest->drain_line < b->line_count && lines < SOCKET_DRAIN_LINES; ingest->drain_line++, lines++) {
+            ingest_line(b->pid, b->data + b->starts[ingest->drain_line]);
+        }
+        if (ingest->drain_line == b->line_count) {
+            queue_push(&ingest->free, ingest->draining - 1);
+            ingest->draining = 0;
+        }
+    }
+
+    if (lines > most_in_one_drain) { most_in_one_drain = lines; }
+    if (lines > 0) { metrics_set("ingest.socket.messages", (double) (lines_received + metrics_received)); }
+    const double us = (SDL_GetPerformanceCounter() - start) * 1e6 / SDL_GetPerformanceFrequency();
+    if (us > longest_drain_us) { longest_drain_us = us; }
+}
+
+void socket_ingest_close(void) {
+    if (ingest == NULL) { return; }
+
+    if (ingest->thread != NULL) {
+        const uint64_t one = 1;
+        write(ingest->wake_fd, &one, sizeof(one));
+        SDL_WaitThread(ingest->thread, NULL);
+    }
+    for (int i = 0; i < SOCKET_MAX_CONNECTIONS; i++) {
+        if (ingest->connections[i].fd >= 0) { close(ingest->connections[i].fd); }
+    }
+    if (ingest->listen_fd >= 0) {
+        close(ingest->listen_fd);
+        unlink(ingest->path);
+    }
+    if (ingest->epoll_fd >= 0) { close(ingest->epoll_fd); }
+    if (ingest->wake_fd >= 0) { close(ingest->wake_fd); }
+
+    tracked_free(ingest);
+    ingest = NULL;
+}
+
+void socket_ingest_report(void) {
+    printf("Socket ingest: %ld connections (%ld rejected), %ld bytes, %ld lines, %ld metrics (%ld rejected), "
+           "%ld lines cut, %ld stalls on the batch pool, most in one frame %d (longest %.0f us)\n", accepted, rejected,
+           bytes_read, lines_received, metrics_received, metrics_rejected, lines_cut, stalls, most_in_one_drain,
+           longest_drain_us);
+}
+
+#endif
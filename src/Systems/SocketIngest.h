@@ -0,0 +1,22 @@
+#ifndef SOCKET_INGEST_H
+#define SOCKET_INGEST_H
+
+// Accepts newline-delimited messages from local clients on a Unix domain socket. A line is
+// either "metric NAME VALUE" or a log line, optionally starting with its level ("debug ",
+// "info ", "warn " or "error "). Log lines go to the logger in the external category and
+// metrics to the metrics table.
+//
+// A background thread serves every connection with epoll and splits lines in place in
+// pooled batches, which reach the UI thread through a lock-free queue. Needs epoll, so it
+// is only available on Linux.
+int socket_ingest_open(const char *path);
+
+// Hands up to SOCKET_DRAIN_LINES queued lines to the logger and metrics; call once per
+// frame on the UI thread
+void socket_ingest_drain(void);
+
+void socket_ingest_close(void);
+
+void socket_ingest_report(void);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef SUBSYSTEM_H
+#define SUBSYSTEM_H
+
+#include <SDL2/SDL.h>
+
+// Everything SiFe uses from SDL; leaving the rest out means launching never pays for
+// probing audio, joystick or sensor devices
+#define SUBSYSTEM_STARTUP_FLAGS (SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER)
+
+#endif
@@ -0,0 +1,182 @@
+#include "TimeSeries.h"
+#include "src/Constants.h"
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    Uint64 time_ms;
+    double value;
+} Sample;
+
+typedef struct {
+    float min;
+    float max;
+    double sum;
+    unsigned count;
+} Rollup;
+
+/*
+ * Rollup rings are indexed by bucket number, time_ms / width, modulo their capacity, and
+ * newest is the highest bucket number written. A sample for a later bucket clears every
+ * bucket it skips over, so a slot holds either its own bucket or nothing; buckets more than
+ * a capacity behind newest are gone.
+ */
+typedef struct {
+    Rollup *buckets;
+    int capacity;
+    Uint64 width_ms;
+    long newest;
+} RollupLevel;
+
+typedef struct {
+    char name[TIME_SERIES_NAME_MAX];
+    Sample raw[TIME_SERIES_RAW_SAMPLES];
+    long raw_count;
+    Rollup seconds[TIME_SERIES_SECOND_BUCKETS];
+    Rollup minutes[TIME_SERIES_MINUTE_BUCKETS];
+    RollupLevel levels[TIME_SERIES_RESOLUTION_COUNT];
+} Series;
+
+static Series series_table[TIME_SERIES_MAX];
+static int series_count;
+static long samples_added;
+
+int time_series_open(const char *name) {
+    for (int i = 0; i < series_count; i++) {
+        if (strncmp(series_table[i].name, name, TIME_SERIES_NAME_MAX - 1) == 0) { return i; }
+    }
+    if (series_count == TIME_SERIES_MAX) { return -1; }
+
+    Series *s = &series_table[series_count];
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    s->raw_count = 0;
+    s->levels[TIME_SERIES_SECONDS] = (RollupLevel) {s->seconds, TIME_SERIES_SECOND_BUCKETS, 1000, -1};
+    s->levels[TIME_SERIES_MINUTES] = (RollupLevel) {s->minutes, TIME_SERIES_MINUTE_BUCKETS, 60 * 1000, -1};
+    return series_count++;
+}
+
+int time_series_count(void) {
+    return series_count;
+}
+
+const char *time_series_name(const int series) {
+    return series >= 0 && series < series_count ? series_table[series].name : NULL;
+}
+
+static void roll_up(RollupLevel *level, const Uint64 time_ms, const double value) {
+    const long bucket = (long) (time_ms / level->width_ms);
+    if (bucket > level->newest) {
+        // Every slot is cleared once the gap covers the whole ring
+        const int all = level->newest < 0 || bucket - level->newest >= level->capacity;
+        const long from = all ? 0 : level->newest + 1;
+        const long to = all ? level->capacity - 1 : bucket;
+        for (long b = from; b <= to; b++) {
+            level->buckets[b % level->capacity] = (Rollup) {FLT_MAX, -FLT_MAX, 0.0, 0};
+        }
+        level->newest = bucket;
+    } else if (bucket <= level->newest - level->capacity) {
+        return;
+    }
+
+    Rollup *r = &level->buckets[bucket % level->capacity];
+    const float v = (float) value;
+    if (v < r->min) { r->min = v; }
+    if (v > r->max) { r->max = v; }
+    r->sum += value;
+    r->count++;
+}
+
+Uint64 time_series_latest(const int series) {
+    if (series < 0 || series >= series_count) { return 0; }
+    const Series *s = &series_table[series];
+    return s->raw_count > 0 ? s->raw[(s->raw_count - 1) % TIME_SERIES_RAW_SAMPLES].time_ms : 0;
+}
+
+void time_series_add(const int series, Uint64 time_ms, const double value) {
+    if (series < 0 || series >= series_count) { return; }
+    Series *s = &series_table[series];
+
+    // Raw samples stay sorted so reads can search them
+    const Uint64 latest = time_series_latest(series);
+    if (time_ms < latest) { time_ms = latest; }
+
+    s->raw[s->raw_count % TIME_SERIES_RAW_SAMPLES] = (Sample) {time_ms, value};
+    s->raw_count++;
+    roll_up(&s->levels[TIME_SERIES_SECONDS], time_ms, value);
+    roll_up(&s->levels[TIME_SERIES_MINUTES], time_ms, value);
+    samples_added++;
+}
+
+static long oldest_raw(const Series *s) {
+    return s->raw_count > TIME_SERIES_RAW_SAMPLES ? s->raw_count - TIME_SERIES_RAW_SAMPLES : 0;
+}
+
+// Number of the first held raw sample at or after time_ms
+static long find_raw(const Series *s, const Uint64 time_ms) {
+    long lo = oldest_raw(s), hi = s->raw_count;
+    while (lo < hi) {
+        const long mid = lo + (hi - lo) / 2;
+        if (s->raw[mid % TIME_SERIES_RAW_SAMPLES].time_ms < time_ms) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+TimeSeriesResolution time_series_pick(const int series, const Uint64 from_ms, const Uint64 to_ms,
+                                      const int max_points) {
+    if (series < 0 || series >= series_count) { return TIME_SERIES_MINUTES; }
+    const Series *s = &series_table[series];
+
+    const long oldest = oldest_raw(s);
+    if (s->raw_count > 0 && (oldest == 0 || s->raw[oldest % TIME_SERIES_RAW_SAMPLES].time_ms <= from_ms) &&
+        find_raw(s, to_ms + 1) - find_raw(s, from_ms) <= max_points) {
+        return TIME_SERIES_RAW;
+    }
+
+    const RollupLevel *seconds = &s->levels[TIME_SERIES_SECONDS];
+    const long first = (long) (from_ms / seconds->width_ms);
+    if (first > seconds->newest - seconds->capacity && (long) (to_ms / seconds->width_ms) - first < max_points) {
+        return TIME_SERIES_SECONDS;
+    }
+    return TIME_SERIES_MINUTES;
+}
+
+int time_series_read(const int series, const TimeSeriesResolution resolution, const Uint64 from_ms,
+                     const Uint64 to_ms, TimeSeriesPoint *out, const int max) {
+    if (series < 0 || series >= series_count || from_ms > to_ms) { return 0; }
+    const Series *s = &series_table[series];
+    int count = 0;
+
+    if (resolution == TIME_SERIES_RAW) {
+        for (long i = find_raw(s, from_ms); i < s->raw_count && count < max; i++) {
+            const Sample *sample = &s->raw[i % TIME_SERIES_RAW_SAMPLES];
+            if (sample->time_ms > to_ms) { break; }
+            const float v = (float) sample->value;
+            out[count++] = (TimeSeriesPoint) {sample->time_ms, v, v, v};
+        }
+        return count;
+    }
+
+    const RollupLevel *level = &s->levels[resolution];
+    if (level->newest < 0) { return 0; }
+    long first = (long) (from_ms / level->width_ms);
+    long last = (long) (to_ms / level->width_ms);
+    if (first <= level->newest - level->capacity) { first = level->newest - level->capacity + 1; }
+    if (last > level->newest) { last = level->newest; }
+
+    for (long b = first; b <= last && count < max; b++) {
+        const Rollup *r = &level->buckets[b % level->capacity];
+        if (r->count == 0) { continue; }
+        out[count++] = (TimeSeriesPoint) {(Uint64) b * level->width_ms, r->min, r->max, (float) (r->sum / r->count)};
+    }
+    return count;
+}
+
+void time_series_report(void) {
+    printf("Time series: %d, %ld samples (%zu KiB held)\n", series_count, samples_added,
+           sizeof(series_table) / 1024);
+}
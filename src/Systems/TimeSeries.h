@@ -0,0 +1,53 @@
+#ifndef TIME_SERIES_H
+#define TIME_SERIES_H
+
+#include <SDL2/SDL_stdinc.h>
+
+#define TIME_SERIES_NAME_MAX 48
+
+typedef enum {
+    TIME_SERIES_RAW,
+    TIME_SERIES_SECONDS,
+    TIME_SERIES_MINUTES,
+    TIME_SERIES_RESOLUTION_COUNT
+} TimeSeriesResolution;
+
+// One raw sample, or the samples of one second or minute; raw samples have min, max and
+// avg all equal to the value
+typedef struct {
+    Uint64 time_ms;
+    float min;
+    float max;
+    float avg;
+} TimeSeriesPoint;
+
+// Fixed-memory series of timestamped values. Each keeps its last TIME_SERIES_RAW_SAMPLES
+// samples plus min/max/avg rollups per second and per minute, which are updated as samples
+// arrive, so reading a long window costs one point per bucket rather than a pass over the
+// raw samples. Only the UI thread touches them.
+
+// Index of the series with this name, created on first use, or -1 when all
+// TIME_SERIES_MAX are taken
+int time_series_open(const char *name);
+
+int time_series_count(void);
+
+const char *time_series_name(int series);
+
+// Samples should arrive in time order; an earlier one is recorded at the latest time seen
+void time_series_add(int series, Uint64 time_ms, double value);
+
+// The finest resolution that still holds from_ms and gives at most max_points points up to to_ms
+TimeSeriesResolution time_series_pick(int series, Uint64 from_ms, Uint64 to_ms, int max_points);
+
+// Fills out with up to max points in [from_ms, to_ms], oldest first; seconds and minutes
+// with no samples are skipped. Returns the number of points.
+int time_series_read(int series, TimeSeriesResolution resolution, Uint64 from_ms, Uint64 to_ms,
+                     TimeSeriesPoint *out, int max);
+
+// Latest sample time of the series, 0 before the first
+Uint64 time_series_latest(int series);
+
+void time_series_report(void);
+
+#endif
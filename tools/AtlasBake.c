@@ -0,0 +1,358 @@
+// sife_atlas_bake: repacks the glyph/icon atlas and emits both the binary .sfa atlas and the
+// C header embedded as the runtime fallback.
+//
+//   sife_atlas_bake --out-atlas atlas.sfa --out-header atlas_baked.inl
+//                   [--padding N] [--raw] [--icon NAME=image.pgm ...]
+//   sife_atlas_bake --check-rle scratch.sfa
+//
+// Glyphs and the MicroUI icons come from the source atlas (src/Config/atlas.inl); extra icons
+// are 8-bit binary PGM alpha masks appended after the font and exposed as ATLAS_ICON_<NAME>.
+// --check-rle saves and reloads RLE atlases of patterns that defeat run-length coding,
+// using the given file as scratch, and fails if any comes back different.
+
+#include "src/Config/Atlas.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ICONS (ATLAS_MAX_RECTS - ATLAS_MIN_RECTS)
+#define MIN_PACK_WIDTH 32
+#define MAX_PACK_WIDTH 4096
+#define HEADER_BYTES_PER_LINE 12
+#define CHECK_PATTERNS 7
+
+typedef struct {
+    int id;
+    int w, h;
+    int x, y;
+    const unsigned char *pixels;
+    int stride;
+    int src_x, src_y;
+} BakeItem;
+
+typedef struct {
+    char name[64];
+    int w, h;
+    unsigned char *pixels;
+} Icon;
+
+static BakeItem items[ATLAS_MAX_RECTS];
+static int item_count;
+static Icon icons[MAX_ICONS];
+static int icon_count;
+
+static int load_pgm(const char *path, Icon *icon) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open icon %s\n", path);
+        return -1;
+    }
+
+    int values[3], count = 0;
+    char magic[3] = {0};
+    if (fread(magic, 1, 2, file) != 2 || strcmp(magic, "P5") != 0) {
+        fprintf(stderr, "%s is not a binary PGM\n", path);
+        fclose(file);
+        return -1;
+    }
+
+    // Header: width, height, maxval separated by whitespace and '#' comments
+    while (count < 3) {
+        int c = fgetc(file);
+        if (c == EOF) { break; }
+        if (c == '#') {
+            while (c != '\n' && c != EOF) { c = fgetc(file); }
+        } else if (isdigit(c)) {
+            int v = 0;
+            while (isdigit(c)) {
+                v = v * 10 + (c - '0');
+                c = fgetc(file);
+            }
+            values[count++] = v;
+        }
+    }
+
+    if (count < 3 || values[0] <= 0 || values[1] <= 0 || values[2] != 255) {
+        fprintf(stderr, "Unsupported PGM header in %s (need 8-bit)\n", path);
+        fclose(file);
+        return -1;
+    }
+
+    icon->w = values[0];
+    icon->h = values[1];
+    icon->pixels = malloc((size_t) icon->w * icon->h);
+    const size_t n = (size_t) icon->w * icon->h;
+    if (icon->pixels == NULL || fread(icon->pixels, 1, n, file) != n) {
+        fprintf(stderr, "Truncated PGM data in %s\n", path);
+        free(icon->pixels);
+        icon->pixels = NULL;
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    return 0;
+}
+
+static int compare_items(const void *a, const void *b) {
+    const BakeItem *ia = a, *ib = b;
+    if (ia->h != ib->h) { return ib->h - ia->h; }
+    return ib->w - ia->w;
+}
+
+// Shelf packing over height-sorted items; returns the used height or -1 if an item doesn't fit
+static int pack(const int width, const int padding) {
+    int x = padding, y = padding, shelf_h = 0;
+    for (int i = 0; i < item_count; i++) {
+        BakeItem *item = &items[i];
+        if (item->w + 2 * padding > width) { return -1; }
+        if (x + item->w + padding > width) {
+            x = padding;
+            y += shelf_h + padding;
+            shelf_h = 0;
+        }
+        item->x = x;
+        item->y = y;
+        x += item->w + padding;
+        if (item->h > shelf_h) { shelf_h = item->h; }
+    }
+    return y + shelf_h + padding;
+}
+
+static int choose_width(const int padding, int *out_height) {
+    long best_area = -1;
+    int best_width = 0;
+    for (int width = MIN_PACK_WIDTH; width <= MAX_PACK_WIDTH; width *= 2) {
+        const int height = pack(width, padding);
+        if (height < 0) { continue; }
+        const long area = (long) width * height;
+        if (best_area < 0 || area < best_area) {
+            best_area = area;
+            best_width = width;
+            *out_height = height;
+        }
+    }
+    return best_width;
+}
+
+static int write_header(const char *path, const Atlas *out) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return -1;
+    }
+
+    fprintf(file, "/* Generated by sife_atlas_bake; do not edit. */\n");
+    fprintf(file, "enum { ATLAS_WIDTH = %d, ATLAS_HEIGHT = %d };\n", out->width, out->height);
+    fprintf(file, "#define ATLAS_LINE_HEIGHT %d\n", out->line_height);
+    for (int i = 0; i < icon_count; i++) {
+        fprintf(file, "#define ATLAS_ICON_");
+        for (const char *p = icons[i].name; *p; p++) {
+            fputc(isalnum((unsigned char) *p) ? toupper((unsigned char) *p) : '_', file);
+        }
+        fprintf(file, " %d\n", ATLAS_MIN_RECTS + i);
+    }
+
+    fprintf(file, "\n\nstatic unsigned char atlas_texture[ATLAS_WIDTH * ATLAS_HEIGHT] = {\n");
+    const int pixel_count = out->width * out->height;
+    for (int i = 0; i < pixel_count; i++) {
+        if (i % HEADER_BYTES_PER_LINE == 0) { fprintf(file, "  "); }
+        fprintf(file, "0x%02x,", out->pixels[i]);
+        fprintf(file, (i % HEADER_BYTES_PER_LINE == HEADER_BYTES_PER_LINE - 1 || i == pixel_count - 1) ? "\n" : " ");
+    }
+    fprintf(file, "};\n\nstatic mu_Rect atlas[] = {\n");
+
+    static const char *icon_names[] = {
+        [MU_ICON_CLOSE] = "MU_ICON_CLOSE", [MU_ICON_CHECK] = "MU_ICON_CHECK",
+        [MU_ICON_COLLAPSED] = "MU_ICON_COLLAPSED", [MU_ICON_EXPANDED] = "MU_ICON_EXPANDED",
+        [ATLAS_WHITE] = "ATLAS_WHITE"
+    };
+    for (int i = 0; i < out->rect_count; i++) {
+        const mu_Rect r = out->rects[i];
+        if (r.w == 0 && r.h == 0) { continue; }
+        if (i < ATLAS_FONT) {
+            fprintf(file, "  [ %s ] = { %d, %d, %d, %d },\n", icon_names[i], r.x, r.y, r.w, r.h);
+        } else if (i < ATLAS_MIN_RECTS) {
+            fprintf(file, "  [ ATLAS_FONT+%d ] = { %d, %d, %d, %d },\n", i - ATLAS_FONT, r.x, r.y, r.w, r.h);
+        } else {
+            fprintf(file, "  [ %d ] = { %d, %d, %d, %d },\n", i, r.x, r.y, r.w, r.h);
+        }
+    }
+    fprintf(file, "};\n");
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static void fill_pattern(unsigned char *pixels, const unsigned count, const int pattern) {
+    unsigned run = 1, left = 1;
+    unsigned char value = 0;
+    for (unsigned i = 0; i < count; i++) {
+        switch (pattern) {
+            case 0:
+                pixels[i] = 0;
+                break;
+            case 1:
+                pixels[i] = i % 3 == 2 ? 7 : 0;
+                break;
+            case 2:
+                pixels[i] = i % 3 == 0 ? 7 : 0;
+                break;
+            case 3:
+                pixels[i] = (unsigned char) (i & 1);
+                break;
+            case 4:
+                pixels[i] = (unsigned char) ((i * 2654435761u) >> 24);
+                break;
+            case 5:
+                // Runs of every length from 1 to 140, so packets split at each limit
+                if (--left == 0) {
+                    run = run % 140 + 1;
+                    left = run;
+                    value ^= 1;
+                }
+                pixels[i] = value;
+                break;
+            default:
+                pixels[i] = (unsigned char) (i / 2 % 2);
+                break;
+        }
+    }
+}
+
+static int check_rle(const char *path) {
+    static const int sizes[][2] = {{1, 1}, {2, 1}, {3, 1}, {127, 1}, {129, 1}, {131, 3}, {300, 300}};
+    static Atlas src, loaded;
+    src.line_height = 1;
+    src.rect_count = ATLAS_MIN_RECTS;
+    for (int i = 0; i < ATLAS_MIN_RECTS; i++) { src.rects[i] = mu_rect(0, 0, 1, 1); }
+
+    int failures = 0;
+    for (int s = 0; s < (int) (sizeof(sizes) / sizeof(sizes[0])); s++) {
+        src.width = sizes[s][0];
+        src.height = sizes[s][1];
+        const unsigned count = (unsigned) (src.width * src.height);
+        unsigned char *pixels = malloc(count);
+        if (pixels == NULL) { return 1; }
+        src.pixels = pixels;
+
+        for (int pattern = 0; pattern < CHECK_PATTERNS; pattern++) {
+            fill_pattern(pixels, count, pattern);
+            if (atlas_save(&src, path, ATLAS_FLAG_RLE) != 0 || atlas_load(&loaded, path) != 0) {
+                failures++;
+                continue;
+            }
+            if (loaded.width != src.width || loaded.height != src.height ||
+                memcmp(loaded.pixels, pixels, count) != 0) {
+                fprintf(stderr, "RLE round trip of pattern %d at %dx%d changed the pixels\n", pattern, src.width,
+                        src.height);
+                failures++;
+            }
+            atlas_release_pixels(&loaded);
+        }
+        free(pixels);
+    }
+
+    remove(path);
+    if (failures > 0) { return 1; }
+    printf("sife_atlas_bake: RLE round trips of %d patterns match\n",
+           CHECK_PATTERNS * (int) (sizeof(sizes) / sizeof(sizes[0])));
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *out_atlas = NULL;
+    const char *out_header = NULL;
+    int padding = 1;
+    int flags = ATLAS_FLAG_RLE;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check-rle") == 0 && i + 1 < argc) {
+            return check_rle(argv[i + 1]);
+        } else if (strcmp(argv[i], "--out-atlas") == 0 && i + 1 < argc) {
+            out_atlas = argv[++i];
+        } else if (strcmp(argv[i], "--out-header") == 0 && i + 1 < argc) {
+            out_header = argv[++i];
+        } else if (strcmp(argv[i], "--padding") == 0 && i + 1 < argc) {
+            padding = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--raw") == 0) {
+            flags &= ~ATLAS_FLAG_RLE;
+        } else if (strcmp(argv[i], "--icon") == 0 && i + 1 < argc) {
+            const char *spec = argv[++i];
+            const char *eq = strchr(spec, '=');
+            if (eq == NULL || eq == spec || icon_count >= MAX_ICONS) {
+                fprintf(stderr, "Invalid or too many --icon entries: %s\n", spec);
+                return 1;
+            }
+            Icon *icon = &icons[icon_count];
+            snprintf(icon->name, sizeof(icon->name), "%.*s", (int) (eq - spec), spec);
+            if (load_pgm(eq + 1, icon) != 0) { return 1; }
+            icon_count++;
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if ((out_atlas == NULL && out_header == NULL) || padding < 0) {
+        fprintf(stderr, "usage: %s --out-atlas FILE --out-header FILE [--padding N] "
+                        "[--raw] [--icon NAME=image.pgm ...]\n"
+                        "       %s --check-rle SCRATCH_FILE\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    Atlas src;
+    atlas_load_embedded(&src);
+
+    for (int id = 0; id < src.rect_count; id++) {
+        const mu_Rect r = src.rects[id];
+        if (r.w <= 0 || r.h <= 0) { continue; }
+        items[item_count++] = (BakeItem){
+            .id = id, .w = r.w, .h = r.h,
+            .pixels = src.pixels, .stride = src.width, .src_x = r.x, .src_y = r.y
+        };
+    }
+    for (int i = 0; i < icon_count; i++) {
+        items[item_count++] = (BakeItem){
+            .id = ATLAS_MIN_RECTS + i, .w = icons[i].w, .h = icons[i].h,
+            .pixels = icons[i].pixels, .stride = icons[i].w
+        };
+    }
+
+    qsort(items, item_count, sizeof(items[0]), compare_items);
+    int height = 0;
+    const int width = choose_width(padding, &height);
+    if (width == 0) {
+        fprintf(stderr, "Atlas contents do not fit in %dpx wide texture\n", MAX_PACK_WIDTH);
+        return 1;
+    }
+    pack(width, padding);
+
+    static Atlas out;
+    out.width = width;
+    out.height = height;
+    out.line_height = src.line_height;
+    out.rect_count = ATLAS_MIN_RECTS + icon_count;
+    unsigned char *pixels = calloc((size_t) width * height, 1);
+    if (pixels == NULL) { return 1; }
+
+    for (int i = 0; i < item_count; i++) {
+        const BakeItem *item = &items[i];
+        for (int y = 0; y < item->h; y++) {
+            memcpy(pixels + (item->y + y) * width + item->x,
+                   item->pixels + (item->src_y + y) * item->stride + item->src_x, item->w);
+        }
+        out.rects[item->id] = mu_rect(item->x, item->y, item->w, item->h);
+    }
+    out.pixels = pixels;
+
+    if (out_atlas != NULL && atlas_save(&out, out_atlas, flags) != 0) { return 1; }
+    if (out_header != NULL && write_header(out_header, &out) != 0) { return 1; }
+
+    printf("sife_atlas_bake: %d rects packed into %dx%d (%d%% of source area)\n",
+           item_count, width, height, (int) (100L * width * height / (src.width * src.height)));
+    return 0;
+}
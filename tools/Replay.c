@@ -0,0 +1,172 @@
+// sife_replay: renders a trace recorded with `SiFe --record FILE` as fast as possible and
+// reports what each frame cost the renderer.
+//
+//   sife_replay TRACE [--atlas FILE] [--loops N] [--csv FILE] [--present] [--instanced] [--sdf-text] [--layers]
+//
+// Each frame is timed from command_buffer_render to glFinish, so the numbers cover command
+// submission plus GPU execution but not the swap unless --present is given.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/Config/CommandBuffer.h"
+#include "src/Config/LayerCache.h"
+#include "src/Config/Renderer.h"
+#include "src/Config/Trace.h"
+
+#define INITIAL_SAMPLE_CAPACITY 4096
+
+SDL_Window *window = NULL;
+
+static int compare_doubles(const void *a, const void *b) {
+    const double da = *(const double *) a, db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+static double percentile(const double *sorted, const int count, const int pct) {
+    const int idx = (int) ((long) (count - 1) * pct / 100);
+    return sorted[idx];
+}
+
+int main(int argc, char **argv) {
+    const char *trace_path = NULL;
+    const char *atlas_path = NULL;
+    const char *csv_path = NULL;
+    int loops = 1;
+    int present = 0;
+    int instanced = 0;
+    int layers = 0;
+    int sdf_text = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--atlas") == 0 && i + 1 < argc) {
+            atlas_path = argv[++i];
+        } else if (strcmp(argv[i], "--loops") == 0 && i + 1 < argc) {
+            loops = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--present") == 0) {
+            present = 1;
+        } else if (strcmp(argv[i], "--instanced") == 0) {
+            instanced = 1;
+        } else if (strcmp(argv[i], "--layers") == 0) {
+            layers = 1;
+        } else if (strcmp(argv[i], "--sdf-text") == 0) {
+            instanced = 1;
+            sdf_text = 1;
+        } else if (trace_path == NULL && argv[i][0] != '-') {
+            trace_path = argv[i];
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (trace_path == NULL || loops < 1) {
+        fprintf(stderr, "usage: %s TRACE [--atlas FILE] [--loops N] [--csv FILE] [--present] [--instanced] [--sdf-text] [--layers]\n", argv[0]);
+        return 1;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    // Every failure below exits through cleanup, which copes with whatever isn't set up yet
+    int result = 1;
+    TraceReader reader = {.file = NULL};
+    int capacity = INITIAL_SAMPLE_CAPACITY, count = 0;
+    double *samples = NULL;
+    FILE *csv = NULL;
+    CommandBuffer *buf = calloc(1, sizeof(CommandBuffer));
+    if (buf == NULL || trace_reader_open(&reader, trace_path) != 0) { goto cleanup; }
+
+    // The window is sized from the first frame; later frames may be larger and are clipped
+    if (trace_reader_next(&reader, buf) != 1) {
+        fprintf(stderr, "Trace %s contains no readable frames\n", trace_path);
+        goto cleanup;
+    }
+
+    window = SDL_CreateWindow("sife_replay", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                              buf->width, buf->height, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (window == NULL || r_init(atlas_path) != 0) {
+        fprintf(stderr, "Failed to set up the renderer: %s\n", SDL_GetError());
+        goto cleanup;
+    }
+    SDL_GL_SetSwapInterval(0);
+    if ((instanced && r_enable_instancing() != 0) || (sdf_text && r_enable_sdf_text() != 0)) { goto cleanup; }
+    layer_cache_set_enabled(layers);
+
+    samples = malloc(capacity * sizeof(double));
+    if (csv_path != NULL) {
+        csv = fopen(csv_path, "w");
+        if (csv == NULL) { fprintf(stderr, "Failed to open %s for writing\n", csv_path); }
+    }
+    if (samples == NULL || (csv_path != NULL && csv == NULL)) { goto cleanup; }
+    if (csv != NULL) {
+        fprintf(csv, "loop,frame,events,command_bytes,render_us\n");
+    }
+    const double ticks_per_us = SDL_GetPerformanceFrequency() / 1000000.0;
+
+    int out_of_memory = 0;
+    for (int loop = 0; loop < loops && !out_of_memory; loop++) {
+        if (loop > 0) {
+            trace_reader_close(&reader);
+            if (trace_reader_open(&reader, trace_path) != 0 || trace_reader_next(&reader, buf) != 1) { break; }
+        }
+
+        int status = 1;
+        for (int frame = 0; status == 1 && !out_of_memory; frame++) {
+            const uint64_t start = SDL_GetPerformanceCounter();
+            command_buffer_render(buf);
+            if (present) {
+                r_present();
+            }
+            glFinish();
+            const double us = (SDL_GetPerformanceCounter() - start) / ticks_per_us;
+
+            if (count == capacity) {
+                double *grown = realloc(samples, 2 * capacity * sizeof(double));
+                if (grown == NULL) {
+                    fprintf(stderr, "Out of memory after %d frames; reporting those\n", count);
+                    out_of_memory = 1;
+                    break;
+                }
+                samples = grown;
+                capacity *= 2;
+            }
+            samples[count++] = us;
+            if (csv != NULL) {
+                fprintf(csv, "%d,%d,%d,%d,%.1f\n", loop, frame, reader.event_count, buf->size, us);
+            }
+
+            status = trace_reader_next(&reader, buf);
+        }
+
+        if (status < 0) {
+            fprintf(stderr, "Trace %s is truncated or corrupt after frame %d\n", trace_path, reader.frame);
+            break;
+        }
+    }
+
+    if (count > 0) {
+        double total = 0;
+        for (int i = 0; i < count; i++) { total += samples[i]; }
+        qsort(samples, count, sizeof(double), compare_doubles);
+        printf("%d frames, render cost in us: mean %.1f  p50 %.1f  p95 %.1f  p99 %.1f  max %.1f\n",
+               count, total / count, percentile(samples, count, 50), percentile(samples, count, 95),
+               percentile(samples, count, 99), samples[count - 1]);
+    }
+    result = 0;
+
+cleanup:
+    trace_reader_close(&reader);
+    if (csv != NULL) { fclose(csv); }
+    free(samples);
+    free(buf);
+    if (window != NULL) { SDL_DestroyWindow(window); }
+    SDL_Quit();
+    return result;
+}
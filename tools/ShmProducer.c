@@ -0,0 +1,116 @@
+// sife_shm_producer: publishes log lines and metrics to a SiFe started with --shm NAME,
+// for trying out shared-memory ingestion and its drop accounting.
+//
+//   sife_shm_producer NAME [--count N] [--rate N] [--threads N]
+//
+// Each thread sends count lines, at rate lines per second (0 sends as fast as it can),
+// plus a counter and a latency metric every tenth line, then prints what was dropped.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "src/Client/SifeClient.h"
+
+#define MAX_THREADS 64
+
+typedef struct {
+    SifeClient *client;
+    int thread;
+    long count;
+    long rate;
+    long sent;
+} Producer;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *run_producer(void *arg) {
+    Producer *p = arg;
+    char text[128], name[64];
+    snprintf(name, sizeof(name), "producer.%d.sent", p->thread);
+    const double start = now_seconds();
+
+    for (long i = 0; i < p->count; i++) {
+        if (p->rate > 0) {
+            // Sleep until this line is due rather than pacing each one, so the rate holds
+            const double due = start + (double) i / p->rate;
+            const double wait = due - now_seconds();
+            if (wait > 0) {
+                const struct timespec ts = {(time_t) wait, (long) ((wait - (time_t) wait) * 1e9)};
+                nanosleep(&ts, NULL);
+            }
+        }
+
+        snprintf(text, sizeof(text), "thread %d line %ld", p->thread, i);
+        const int level = i % 100 == 99 ? SIFE_LEVEL_WARN : SIFE_LEVEL_INFO;
+        if (sife_client_log(p->client, level, text) == 0) { p->sent++; }
+        if (i % 10 == 0) {
+            const double before = now_seconds();
+            sife_client_metric(p->client, name, (double) i);
+            sife_client_metric(p->client, "producer.publish_us", (now_seconds() - before) * 1e6);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const char *name = NULL;
+    long count = 10000;
+    long rate = 0;
+    int threads = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (name == NULL && argv[i][0] != '-') {
+            name = argv[i];
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (name == NULL || count < 0 || rate < 0 || threads < 1 || threads > MAX_THREADS) {
+        fprintf(stderr, "usage: %s NAME [--count N] [--rate N] [--threads N]\n", argv[0]);
+        return 1;
+    }
+
+    SifeClient *client = sife_client_open(name);
+    if (client == NULL) {
+        fprintf(stderr, "Failed to create the client\n");
+        return 1;
+    }
+
+    Producer producers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    const double start = now_seconds();
+    for (int t = 0; t < threads; t++) {
+        producers[t] = (Producer) {.client = client, .thread = t, .count = count, .rate = rate};
+        if (pthread_create(&ids[t], NULL, run_producer, &producers[t]) != 0) {
+            fprintf(stderr, "Failed to start thread %d\n", t);
+            threads = t;
+            break;
+        }
+    }
+
+    long sent = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+        sent += producers[t].sent;
+    }
+    const double elapsed = now_seconds() - start;
+
+    printf("%ld lines sent in %.2f s (%.0f/s), %lu messages dropped\n", sent, elapsed,
+           elapsed > 0 ? sent / elapsed : 0.0, sife_client_dropped(client));
+    sife_client_close(client);
+    return 0;
+}
@@ -0,0 +1,90 @@
+// sife_viewer: thin client for `SiFe --remote ADDRESS`. Receives delta-encoded frames over
+// a Unix or TCP socket and draws them with the regular renderer.
+//
+//   sife_viewer unix:/tmp/sife.sock
+//   sife_viewer tcp:host:port [--atlas FILE]
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/Config/CommandBuffer.h"
+#include "src/Config/RemoteDisplay.h"
+#include "src/Config/Renderer.h"
+
+#define RECEIVE_TIMEOUT_MS 16
+
+SDL_Window *window = NULL;
+
+int main(int argc, char **argv) {
+    const char *address = NULL;
+    const char *atlas_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--atlas") == 0 && i + 1 < argc) {
+            atlas_path = argv[++i];
+        } else if (address == NULL && argv[i][0] != '-') {
+            address = argv[i];
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (address == NULL) {
+        fprintf(stderr, "usage: %s unix:PATH|tcp:HOST:PORT [--atlas FILE]\n", argv[0]);
+        return 1;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    RemoteViewer *viewer = remote_viewer_connect(address);
+    CommandBuffer *buf = calloc(1, sizeof(CommandBuffer));
+    if (viewer == NULL || buf == NULL) {
+        SDL_Quit();
+        return 1;
+    }
+
+    // Frames are in drawable pixels; the window is resized to match whatever arrives
+    window = SDL_CreateWindow("sife_viewer", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                              640, 480, SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN);
+    if (window == NULL || r_init(atlas_path) != 0) {
+        fprintf(stderr, "Failed to set up the renderer: %s\n", SDL_GetError());
+        remote_viewer_close(viewer);
+        SDL_Quit();
+        return 1;
+    }
+
+    int running = 1, frames = 0;
+    while (running) {
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) {
+            if (e.type == SDL_QUIT) { running = 0; }
+        }
+
+        const int status = remote_viewer_receive(viewer, buf, RECEIVE_TIMEOUT_MS);
+        if (status < 0) {
+            printf("Connection closed after %d frames\n", frames);
+            break;
+        }
+        if (status == 0) { continue; }
+
+        int w, h;
+        SDL_GL_GetDrawableSize(window, &w, &h);
+        if (w != buf->width || h != buf->height) {
+            SDL_SetWindowSize(window, buf->width, buf->height);
+        }
+        command_buffer_render(buf);
+        r_present();
+        frames++;
+    }
+
+    remote_viewer_close(viewer);
+    free(buf);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}